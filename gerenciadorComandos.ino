@@ -32,10 +32,28 @@
  */
  
  #include "gerenciadorComandos.h"
+#include "configuracao.h" // Configuração persistente (comandos "salvar" e "carregar").
+#include "diario.h"       // Diário de alterações (grava automaticamente cada "definir" na EEPROM).
+#include "etapasDespacho.h" // Orçamento de tempo dos comandos (e watchdog opcional).
+#include "padrao.h"       // Sequências de liga/desliga (comando "padrao").
+#include "brilho.h"       // Controle de brilho (comandos "brilho" e "fade").
 
 gerenciadorComando gerenciador; // Cria um objeto (instância) da classe gerenciadorComando.
                                 // Este objeto será usado para acessar as funções da classe, como analisarComando e processarComando.
 
+// Interface Modbus-RTU opcional (mapa de registradores descrito em modbusRTU.h).
+// Mude para 1 para atender um CLP pela Serial1 (placas com mais de uma porta serial, como o Arduino Mega).
+#define USAR_MODBUS 0
+#if USAR_MODBUS
+#include "modbusRTU.h"
+escravoModbus modbus(1); // Endereço Modbus desta placa.
+#endif
+
+// Módulos opcionais que ocupam timers e interrupções das placas AVR. Como a biblioteca é compilada
+// separadamente do sketch, são ativados nas opções de compilação (ex: build_flags no PlatformIO):
+// -DGC_AMOSTRAGEM=1 ativa o comando "amostrar" (Timer1 e interrupção do ADC; conflita com a biblioteca Servo).
+// -DGC_BRILHO=1 ativa os comandos "brilho" e "fade" (Timer2; conflita com tone()).
+
 // Variaveis
 const int ledPin = 13; // Define o pino digital 13 como o pino do LED. 'const' significa que este valor não pode ser alterado durante a execução do programa.
                        // Este é o LED embutido na maioria das placas Arduino Uno.
@@ -43,25 +61,33 @@ const int ledPin = 13; // Define o pino digital 13 como o pino do LED. 'const' s
 void setup() {
   Serial.begin(9600); // Inicializa a comunicação serial com uma taxa de 9600 bauds.
                       // Isso configura o Arduino para se comunicar com o computador (ou outro dispositivo) pela porta serial.
+  informarReinicioDuranteComando(); // Se a placa reiniciou no meio de um comando (ex: pelo watchdog), informa qual.
   pinMode(ledPin, OUTPUT); // Configura o pino ledPin (pino 13) como uma saída.
                            // Isso significa que o Arduino pode enviar um sinal elétrico para este pino, ligando ou desligando o LED.
-}
-
-void loop() {
-  if (Serial.available() > 0) {// Verifica se há dados disponíveis para leitura na porta serial.
-                                // Serial.available() retorna o número de bytes disponíveis para leitura. Se for maior que 0, significa que há dados para serem lidos.
+  carregarConfiguracao(); // Restaura os parâmetros e o estado do piscar gravados pelo comando "salvar" (se houver uma configuração válida).
+                          // Assim a placa volta a operar com a última configuração salva, sem esperar que o computador a envie novamente.
+  recuperarDiario(); // Aplica as alterações feitas com "definir" depois do último "salvar".
 
-    String comandoRecebido = Serial.readStringUntil('\n'); // Lê uma string da porta serial até encontrar um caractere de nova linha ('\n').
-                                                           // Este caractere é tipicamente enviado quando você pressiona Enter no monitor serial.
-                                                           // A string lida é armazenada na variável comandoRecebido.
+  // Para várias placas em um mesmo barramento RS-485, descomente as linhas abaixo:
+  // gerenciador.definirEndereco(12);    // Esta placa responde apenas a linhas iniciadas por "@12 " (e à difusão "@0 ").
+  // gerenciador.definirPinoDirecao(2);  // Pino ligado ao DE/RE do transceptor RS-485 (habilitado só durante as respostas).
 
-    Comando comando = gerenciador.analisarComando(comandoRecebido); // Chama a função analisarComando do objeto gerenciador.
-                                                                    // Esta função processa a string recebida e extrai o nome do comando e seus argumentos (se houver).
-                                                                    // O resultado é armazenado em um struct Comando (uma estrutura de dados).
+#if USAR_MODBUS
+  Serial1.begin(19200);
+  modbus.iniciar(Serial1, 19200); // O silêncio que separa os quadros depende da taxa de transmissão.
+#endif
+}
 
-    gerenciador.processarComando(comando); // Chama a função processarComando do objeto gerenciador.
-                                           // Esta função recebe o struct Comando e executa a ação correspondente ao comando recebido, usando uma tabela de comandos.
-    }
+void loop() {
+  gerenciador.atualizar(); // Entrega ao gerenciador os bytes recebidos pela Serial, um a um.
+                           // O nome do comando é reconhecido enquanto os bytes chegam, e quando a linha termina ('\n')
+                           // a função correspondente ao comando é executada imediatamente, usando a tabela de comandos.
+  atualizarDiario(); // Grava as alterações pendentes na EEPROM, um byte por vez, sem atrasar o loop().
+  atualizarPadroes(); // Avança os padrões iniciados pelo comando "padrao" (uma comparação de tempo por pino).
+  atualizarBrilho(); // Avança os fades (o brilho em si é modulado pela interrupção do Timer2).
+#if USAR_MODBUS
+  modbus.atualizar(); // Responde às requisições Modbus recebidas pela Serial1.
+#endif
 
   // Esta parte controla o piscar do LED e deve permanecer dentro do loop(), pois precisa ser executada repetidamente para funcionar.
   // Ela não usa diretamente a tabelaComandos, mas depende da variável global piscarAtivo, que é modificada pela função tratarPiscarLed dentro do gerenciadorComandos.
@@ -0,0 +1,274 @@
+/*
+ * amostragem.cpp
+ *
+ * Descrição:
+ * Aquisição de sinais em alta taxa. Veja amostragem.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "modbusRTU.h" // crc16Modbus.
+#include "amostragem.h"
+
+#if GC_AMOSTRAGEM
+
+#if defined(__AVR__) && defined(TCCR1A)
+#define GC_AMOSTRAGEM_TIMER 1 // Coleta pela interrupção de comparação do Timer1.
+#else
+#define GC_AMOSTRAGEM_TIMER 0 // Coleta no horário de cada amostra, por atualizarAmostragem().
+#endif
+
+static const uint8_t TAMANHO_BLOCO = 8 + 2 * GC_AMOSTRAS_BLOCO;
+static const uint8_t INICIO_BLOCO = 0x02;
+
+struct BlocoAmostras {
+  uint16_t amostras[GC_AMOSTRAS_BLOCO];
+  volatile uint8_t quantidade;  // Amostras já coletadas.
+  volatile bool pronto;         // Bloco cheio (ou último), aguardando envio.
+};
+
+// Estado compartilhado com a interrupção.
+static BlocoAmostras blocos[2];
+static volatile uint8_t blocoColeta = 0;        // Bloco sendo preenchido.
+static volatile bool amostrando = false;
+static volatile bool continuo = false;          // n = 0: sem limite de amostras.
+static volatile uint16_t amostrasRestantes = 0;
+static volatile uint8_t perdidasBloco = 0;      // Perdidas desde o último bloco enviado (satura em 255).
+static volatile unsigned long amostrasPerdidas = 0;
+static volatile unsigned long amostrasColetadas = 0;
+static uint8_t pinoAmostragem = 0;
+static uint16_t (*fonteAmostras)(uint8_t pino) = nullptr;
+
+static uint8_t blocoEnvio = 0;       // Próximo bloco a ser enviado.
+static uint16_t sequenciaBloco = 0;
+static bool resumoPendente = false;  // Envia o resumo quando o último bloco sair.
+static bool envioPermitido = true;   // Falso com endereço RS-485: a placa só transmite quando consultada.
+
+#if GC_AMOSTRAGEM_TIMER
+// Configuração do Timer1 antes da amostragem (a do analogWrite() nos pinos 9 e 10, definida pelo init()),
+// restaurada ao final.
+static uint8_t tccr1aAnterior;
+static uint8_t tccr1bAnterior;
+static uint16_t ocr1aAnterior;
+#else
+static unsigned long periodoAmostra = 0; // Em microssegundos.
+static unsigned long proximaAmostra = 0;
+#endif
+
+static uint16_t lerAmostraPadrao(uint8_t pino) {
+  return analogRead(pino);
+}
+
+void definirFonteAmostras(uint16_t (*fonte)(uint8_t pino)) {
+  fonteAmostras = fonte != nullptr ? fonte : lerAmostraPadrao;
+}
+
+void permitirEnvioAmostras(bool permitido) {
+  envioPermitido = permitido;
+}
+
+static void pararColeta() {
+  amostrando = false;
+#if GC_AMOSTRAGEM_TIMER
+  TIMSK1 &= ~_BV(OCIE1A); // Desliga a interrupção e devolve ao Timer1 a configuração anterior.
+  TCCR1B = tccr1bAnterior;
+  TCCR1A = tccr1aAnterior;
+  OCR1A = ocr1aAnterior;
+#endif
+  BlocoAmostras& bloco = blocos[blocoColeta];
+  if (bloco.quantidade > 0 && !bloco.pronto) { // O bloco incompleto também é enviado.
+    bloco.pronto = true;
+    blocoColeta ^= 1;
+  }
+}
+
+static void perderAmostra() {
+  amostrasPerdidas++;
+  if (perdidasBloco < 255) perdidasBloco++;
+}
+
+// Guarda uma amostra no bloco atual (executada nas interrupções do Timer1 e do ADC, ou pelo loop()).
+static void guardarAmostra(uint16_t amostra) {
+  if (!amostrando) return;
+  BlocoAmostras& bloco = blocos[blocoColeta];
+  bool ultima = !continuo && --amostrasRestantes == 0;
+  if (bloco.pronto) {
+    perderAmostra(); // Os dois blocos aguardam envio: a Serial não acompanha a taxa.
+  } else {
+    bloco.amostras[bloco.quantidade++] = amostra;
+    amostrasColetadas++;
+    if (bloco.quantidade == GC_AMOSTRAS_BLOCO || ultima) {
+      bloco.pronto = true;
+      blocoColeta ^= 1; // A próxima amostra vai para o outro bloco.
+    }
+  }
+  if (ultima) pararColeta();
+}
+
+static void coletarAmostra() {
+  guardarAmostra(fonteAmostras(pinoAmostragem));
+}
+
+#if GC_AMOSTRAGEM_TIMER
+ISR(TIMER1_COMPA_vect) {
+  if (fonteAmostras == lerAmostraPadrao) {
+    // O analogRead() ocuparia a interrupção durante toda a conversão (cerca de 104us): a conversão
+    // é apenas iniciada aqui, no canal já selecionado, e a amostra é guardada na interrupção do ADC.
+    ADCSRA |= _BV(ADSC) | _BV(ADIE);
+  } else {
+    coletarAmostra();
+  }
+}
+
+ISR(ADC_vect) {
+  ADCSRA &= ~_BV(ADIE); // Só as conversões iniciadas pelo Timer1 chegam aqui (não as do analogRead()).
+  guardarAmostra(ADC);
+}
+
+static void iniciarTimer(unsigned long taxa) {
+  // Modo CTC: a interrupção ocorre quando o contador chega a OCR1A.
+  // Prescaler 8 para taxas a partir de 31 amostras/s (16MHz); abaixo disso, prescaler 256.
+  unsigned long contagem = F_CPU / 8 / taxa;
+  uint8_t prescaler = _BV(CS11);
+  if (contagem > 65536UL) {
+    contagem = F_CPU / 256 / taxa;
+    prescaler = _BV(CS12);
+  }
+  noInterrupts();
+  tccr1aAnterior = TCCR1A;
+  tccr1bAnterior = TCCR1B;
+  ocr1aAnterior = OCR1A;
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | prescaler;
+  TCNT1 = 0;
+  OCR1A = contagem - 1;
+  TIFR1 = _BV(OCF1A);
+  TIMSK1 |= _BV(OCIE1A);
+  interrupts();
+}
+#endif
+
+// Envia um bloco pronto (no formato descrito em amostragem.h) e o libera para a coleta.
+static void enviarBloco(BlocoAmostras& bloco) {
+  uint8_t quadro[TAMANHO_BLOCO];
+  uint8_t tamanho = 0;
+  quadro[tamanho++] = INICIO_BLOCO;
+  quadro[tamanho++] = 'A';
+  quadro[tamanho++] = sequenciaBloco & 0xFF;
+  quadro[tamanho++] = sequenciaBloco >> 8;
+  sequenciaBloco++;
+  quadro[tamanho++] = bloco.quantidade;
+  noInterrupts();
+  quadro[tamanho++] = perdidasBloco;
+  perdidasBloco = 0;
+  interrupts();
+  for (uint8_t i = 0; i < GC_AMOSTRAS_BLOCO; i++) {
+    uint16_t amostra = i < bloco.quantidade ? bloco.amostras[i] : 0;
+    quadro[tamanho++] = amostra & 0xFF;
+    quadro[tamanho++] = amostra >> 8;
+  }
+  uint16_t crc = crc16Modbus(quadro + 1, tamanho - 1);
+  quadro[tamanho++] = crc & 0xFF;
+  quadro[tamanho++] = crc >> 8;
+  Serial.write(quadro, tamanho);
+  bloco.quantidade = 0;
+  bloco.pronto = false; // Por último: só agora a interrupção pode voltar a preencher o bloco.
+}
+
+void atualizarAmostragem(bool podeEnviar) {
+#if !GC_AMOSTRAGEM_TIMER
+  if (amostrando) {
+    unsigned long agora = micros();
+    if ((long)(agora - proximaAmostra) >= 0) {
+      unsigned long atrasadas = (agora - proximaAmostra) / periodoAmostra; // Horários que passaram sem coleta.
+      for (unsigned long i = 0; i < atrasadas && amostrando; i++) {
+        if (!continuo && --amostrasRestantes == 0) pararColeta(); // Envia também o bloco incompleto.
+        perderAmostra();
+      }
+      proximaAmostra += (atrasadas + 1) * periodoAmostra;
+      coletarAmostra();
+    }
+  }
+#endif
+  if (!podeEnviar) return;
+  if (blocos[blocoEnvio].pronto) {
+    if (Serial.availableForWrite() < TAMANHO_BLOCO) return; // Sem espaço: o bloco sai na próxima chamada.
+    enviarBloco(blocos[blocoEnvio]);
+    blocoEnvio ^= 1;
+    return;
+  }
+  if (resumoPendente && !amostrando && !blocos[blocoEnvio ^ 1].pronto) {
+    resumoPendente = false;
+    Serial.print("Amostragem concluída: ");
+    Serial.print(amostrasColetadas);
+    Serial.print(" amostras, ");
+    Serial.print(amostrasPerdidas);
+    Serial.println(" perdidas.");
+  }
+}
+
+// Trata o comando "amostrar".
+static void tratarAmostrar(Comando comando) {
+  if (comando.numValores == 0) { // "amostrar" sem parâmetros encerra a amostragem em andamento.
+    noInterrupts();
+    if (amostrando) pararColeta();
+    interrupts();
+    return;
+  }
+  if (comando.numValores != 3) {
+    Serial.println("Erro: O comando 'amostrar' espera 3 parâmetros: <pino> <taxa> <n> (ou nenhum, para encerrar).");
+    return;
+  }
+  long pino = comando.valores[0].toInt();
+  long taxa = comando.valores[1].toInt();
+  long n = comando.valores[2].toInt();
+  if (pino < 0 || pino > 255 || taxa < 1 || taxa > GC_TAXA_AMOSTRAGEM_MAXIMA || n < 0 || n > 65535L) {
+    Serial.print("Erro: Use um pino válido, uma taxa de 1 a ");
+    Serial.print(GC_TAXA_AMOSTRAGEM_MAXIMA);
+    Serial.println(" amostras/s e até 65535 amostras.");
+    return;
+  }
+  if (!envioPermitido) { // Os blocos seriam enviados sem consulta, disputando o barramento com as outras placas.
+    Serial.println("Erro: A amostragem não pode ser usada com endereço RS-485.");
+    return;
+  }
+  if (amostrando || resumoPendente) {
+    Serial.println("Erro: Amostragem em andamento (envie 'amostrar' para encerrar).");
+    return;
+  }
+  if (fonteAmostras == nullptr) fonteAmostras = lerAmostraPadrao;
+  pinoAmostragem = pino;
+  continuo = n == 0;
+  amostrasRestantes = n;
+  amostrasColetadas = 0;
+  amostrasPerdidas = 0;
+  perdidasBloco = 0;
+  sequenciaBloco = 0;
+  blocos[0].quantidade = blocos[1].quantidade = 0;
+  blocos[0].pronto = blocos[1].pronto = false;
+  blocoColeta = blocoEnvio = 0;
+  resumoPendente = true;
+  amostrando = true;
+#if GC_AMOSTRAGEM_TIMER
+  if (fonteAmostras == lerAmostraPadrao) analogRead(pino); // Seleciona o canal e a referência usados pela interrupção.
+  iniciarTimer(taxa);
+#else
+  periodoAmostra = 1000000UL / taxa;
+  proximaAmostra = micros();
+#endif
+}
+REGISTRAR_COMANDO("amostrar", tratarAmostrar, "<pino> <taxa> <n>");
+
+#else // Amostragem desativada: nenhuma interrupção é definida.
+
+void definirFonteAmostras(uint16_t (*)(uint8_t)) {}
+void permitirEnvioAmostras(bool) {}
+void atualizarAmostragem(bool) {}
+
+// O comando existe (e aparece na ajuda), mas é recusado.
+static void tratarAmostrar(Comando) {
+  Serial.println("Erro: A amostragem está desativada (compile com -DGC_AMOSTRAGEM=1).");
+}
+REGISTRAR_COMANDO("amostrar", tratarAmostrar, "<pino> <taxa> <n>");
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * amostragem.h
+ *
+ * Descrição:
+ * Aquisição de sinais em alta taxa para bancadas de teste, com o comando
+ * "amostrar <pino> <taxa> <n>": 'n' amostras do pino, 'taxa' amostras por segundo
+ * (n = 0: amostragem contínua). "amostrar" sem parâmetros encerra a amostragem.
+ *
+ * Funcionalidade Principal:
+ * As amostras são coletadas pela interrupção do Timer1 (placas AVR) em dois blocos
+ * alternados: enquanto um bloco é preenchido, o outro é enviado pela Serial, de modo
+ * que os comandos continuam sendo tratados durante a amostragem. Se os dois blocos
+ * estiverem cheios (a Serial não acompanha a taxa pedida), as novas amostras são
+ * descartadas e contadas como perdidas.
+ * Com a fonte padrão (analogRead), a interrupção do Timer1 apenas inicia a conversão
+ * do ADC, e a amostra é guardada pela interrupção do ADC, sem esperar a conversão.
+ * Durante a amostragem o analogWrite() não funciona nos pinos 9 e 10 (Timer1); a configuração
+ * anterior do Timer1 é restaurada ao final.
+ * Nas placas sem Timer1 (e na compilação para testes no computador), as amostras são
+ * coletadas por 'atualizarAmostragem', no horário de cada amostra, e as amostras
+ * cujo horário passou sem coleta também são contadas como perdidas.
+ *
+ * Formato de um bloco (binário, tamanho fixo de 8 + 2 * GC_AMOSTRAS_BLOCO bytes):
+ *   0x02 (STX, nunca presente nas linhas de texto), 'A',
+ *   sequência (2 bytes), amostras válidas no bloco (1 byte), amostras perdidas desde o bloco anterior (1 byte),
+ *   GC_AMOSTRAS_BLOCO amostras de 2 bytes (as posições após as válidas valem 0),
+ *   CRC16 Modbus (2 bytes) de todos os bytes após o STX.
+ * Valores de 2 bytes são enviados com o byte menos significativo primeiro.
+ * Ao final é enviada a linha "Amostragem concluída: N amostras, M perdidas."
+ *
+ * A fonte das amostras é analogRead(pino), e pode ser trocada por 'definirFonteAmostras'
+ * (ex: um sinal sintético para testar o programa do computador sem hardware).
+ *
+ * Os blocos são enviados sem consulta, por isso o comando é recusado em placas com
+ * endereço RS-485 (gerenciadorComando::definirEndereco).
+ *
+ * O módulo é opcional (GC_AMOSTRAGEM): sem ele, o comando "amostrar" é recusado.
+ */
+
+#ifndef AMOSTRAGEM_H
+#define AMOSTRAGEM_H
+
+#include <Arduino.h>
+
+// Ativa a amostragem. Desativada por padrão, pois ocupa o Timer1 e as interrupções TIMER1_COMPA e ADC
+// (placas AVR), que a biblioteca Servo ou o sketch podem já usar (o programa não seria montado).
+// A biblioteca é compilada separadamente do sketch: ative nas opções de compilação (-DGC_AMOSTRAGEM=1).
+#ifndef GC_AMOSTRAGEM
+#define GC_AMOSTRAGEM 0
+#endif
+
+// Amostras por bloco. O bloco inteiro precisa caber no buffer de transmissão da Serial
+// (63 bytes livres nas placas AVR), para ser enviado sem bloquear.
+#ifndef GC_AMOSTRAS_BLOCO
+#define GC_AMOSTRAS_BLOCO 16
+#endif
+#if 8 + 2 * GC_AMOSTRAS_BLOCO > 63
+#error "GC_AMOSTRAS_BLOCO deve ser no máximo 27 (o bloco não caberia no buffer de transmissão)"
+#endif
+// Maior taxa aceita pelo comando "amostrar" (amostras por segundo).
+#ifndef GC_TAXA_AMOSTRAGEM_MAXIMA
+#define GC_TAXA_AMOSTRAGEM_MAXIMA 5000
+#endif
+
+// Troca a fonte das amostras (nullptr restaura analogRead). Chamada também na interrupção: deve ser rápida.
+void definirFonteAmostras(uint16_t (*fonte)(uint8_t pino));
+
+// Permite ou recusa o comando "amostrar". Chamada por gerenciadorComando::definirEndereco():
+// com endereço, a placa só transmite quando consultada e não pode enviar os blocos.
+void permitirEnvioAmostras(bool permitido);
+
+// Envia os blocos prontos (e, sem Timer1, coleta as amostras).
+// Chamada por gerenciadorComando::atualizar() a cada loop(); 'podeEnviar' é falso no meio de uma linha.
+void atualizarAmostragem(bool podeEnviar);
+
+#endif
@@ -0,0 +1,331 @@
+/*
+ * brilho.cpp
+ *
+ * Descrição:
+ * Controle de brilho por modulação por ângulo de bit. Veja brilho.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "padrao.h"
+#include "brilho.h"
+
+static_assert(GC_CANAIS_BRILHO >= 1 && GC_CANAIS_BRILHO <= 32, "GC_CANAIS_BRILHO deve estar entre 1 e 32");
+
+#if GC_BRILHO && defined(__AVR__) && defined(TCCR2A)
+#define GC_BRILHO_TIMER 1 // Modulação pela interrupção de comparação do Timer2.
+#else
+#define GC_BRILHO_TIMER 0 // Desativado, ou sem Timer2 (o loop() não mantém intervalos de 16us): os comandos são recusados.
+#endif
+
+static_assert(255UL * GC_DURACAO_MAXIMA_FADE <= 0x7FFFFFFFUL, "GC_DURACAO_MAXIMA_FADE grande demais para o cálculo do fade");
+
+#if GC_BRILHO_TIMER
+// Correção de luminosidade (CIE 1931): brilho pedido (0 a 255) para o tempo ligado (0 a 255).
+// Calculada na compilação; na memória flash.
+constexpr double cubo(double x) { return x * x * x; }
+constexpr double luminosidade(double l) { // 'l' de 0 a 100; resultado de 0 a 1.
+  return l <= 8 ? l / 903.3 : cubo((l + 16) / 116);
+}
+constexpr uint8_t corrigirBrilho(int i) {
+  return (uint8_t)(luminosidade(i * 100.0 / 255) * 255 + 0.5);
+}
+#define GC_CORRECAO_4(i) corrigirBrilho(i), corrigirBrilho(i + 1), corrigirBrilho(i + 2), corrigirBrilho(i + 3)
+#define GC_CORRECAO_16(i) GC_CORRECAO_4(i), GC_CORRECAO_4(i + 4), GC_CORRECAO_4(i + 8), GC_CORRECAO_4(i + 12)
+#define GC_CORRECAO_64(i) GC_CORRECAO_16(i), GC_CORRECAO_16(i + 16), GC_CORRECAO_16(i + 32), GC_CORRECAO_16(i + 48)
+static const uint8_t tabelaCorrecao[256] PROGMEM = {
+  GC_CORRECAO_64(0), GC_CORRECAO_64(64), GC_CORRECAO_64(128), GC_CORRECAO_64(192)
+};
+static_assert(corrigirBrilho(0) == 0 && corrigirBrilho(255) == 255, "Tabela de correção sem os extremos");
+
+static const uint8_t CANAL_LIVRE = 0xFF;
+
+struct CanalBrilho {
+  uint8_t pino;            // CANAL_LIVRE = canal sem pino.
+  uint8_t brilho;          // Brilho pedido (antes da correção).
+  bool emFade;
+  uint8_t de, para;        // Brilho inicial e final do fade.
+  unsigned long inicio;    // Instante (millis()) do início do fade.
+  unsigned long duracao;   // Duração do fade, em milissegundos (até GC_DURACAO_MAXIMA_FADE).
+  uint8_t porta;           // Índice em 'portasBrilho'.
+  uint8_t bit;             // Bit do pino no registrador da porta.
+};
+static CanalBrilho canais[GC_CANAIS_BRILHO];
+static uint8_t canaisEmUso = 0;
+static bool canaisIniciados = false;
+
+static void iniciarCanais() {
+  if (canaisIniciados) return;
+  for (uint8_t i = 0; i < GC_CANAIS_BRILHO; i++) canais[i].pino = CANAL_LIVRE;
+  canaisIniciados = true;
+}
+
+// Portas com pinos controlados e os seus planos de bit (lidos pela interrupção).
+struct PortaBrilho {
+  volatile uint8_t* saida;        // PORTx
+  volatile uint8_t mascara;       // Pinos controlados nesta porta.
+  volatile uint8_t planos[8];     // Valor dos pinos controlados no intervalo de cada bit.
+};
+static PortaBrilho portasBrilho[GC_CANAIS_BRILHO]; // No pior caso, cada canal em uma porta diferente.
+static volatile uint8_t numPortasBrilho = 0;
+static volatile uint8_t bitAtual = 0;           // Intervalo em andamento.
+static volatile uint8_t intervalosEstourados = 0; // Interrupções que não terminaram dentro do intervalo (satura em 255).
+
+// Configuração do Timer2 antes do primeiro canal (a do analogWrite() nos pinos 3 e 11, definida pelo init()),
+// restaurada quando o último canal é liberado.
+static uint8_t tccr2aAnterior;
+static uint8_t tccr2bAnterior;
+static uint8_t ocr2aAnterior;
+
+// Intervalo do bit 'b': 2 << b contagens de 8us (16us a 2048us), com prescaler 128 a 16MHz.
+ISR(TIMER2_COMPA_vect) {
+  uint8_t b = (bitAtual + 1) & 7;
+  OCR2A = (2 << b) - 1; // Primeiro: no intervalo mais curto restam apenas 2 contagens.
+  bitAtual = b;
+  for (uint8_t p = 0; p < numPortasBrilho; p++) { // Uma escrita por porta, qualquer que seja o número de canais.
+    PortaBrilho& porta = portasBrilho[p];
+    *porta.saida = (*porta.saida & ~porta.mascara) | porta.planos[b];
+  }
+  // O TCNT2 conta de 8 em 8us e não mede o tempo da interrupção contra o intervalo de 16us; mas se a próxima
+  // comparação já aconteceu, esta interrupção passou do fim do intervalo e o brilho dos canais ficou errado.
+  if ((TIFR2 & _BV(OCF2A)) && intervalosEstourados < 255) intervalosEstourados++;
+}
+
+static void iniciarTimer() {
+  noInterrupts();
+  tccr2aAnterior = TCCR2A;
+  tccr2bAnterior = TCCR2B;
+  ocr2aAnterior = OCR2A;
+  TCCR2A = _BV(WGM21);             // Modo CTC.
+  TCCR2B = _BV(CS22) | _BV(CS20);  // Prescaler 128: 8us por contagem a 16MHz.
+  TCNT2 = 0;
+  bitAtual = 7;
+  OCR2A = 1;
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 |= _BV(OCIE2A);
+  interrupts();
+}
+
+static void pararTimer() {
+  noInterrupts();
+  TIMSK2 &= ~_BV(OCIE2A); // Desliga a interrupção e devolve ao Timer2 a configuração anterior.
+  TCCR2B = tccr2bAnterior;
+  TCCR2A = tccr2aAnterior;
+  OCR2A = ocr2aAnterior;
+  interrupts();
+}
+
+// Registra o pino na sua porta (criando a porta, se for a primeira vez).
+static void associarPorta(CanalBrilho& canal) {
+  volatile uint8_t* saida = portOutputRegister(digitalPinToPort(canal.pino));
+  uint8_t p = 0;
+  while (p < numPortasBrilho && portasBrilho[p].saida != saida) p++;
+  if (p == numPortasBrilho) {
+    portasBrilho[p].saida = saida;
+    portasBrilho[p].mascara = 0;
+    memset((void*)portasBrilho[p].planos, 0, sizeof(portasBrilho[p].planos));
+    numPortasBrilho++; // Por último: a interrupção só passa a ler a porta já preenchida.
+  }
+  canal.porta = p;
+  canal.bit = digitalPinToBitMask(canal.pino);
+  portasBrilho[p].mascara |= canal.bit;
+}
+
+// Atualiza os planos de bit do canal.
+static void aplicarBrilho(CanalBrilho& canal) {
+  uint8_t ciclo = pgm_read_byte(&tabelaCorrecao[canal.brilho]);
+  PortaBrilho& porta = portasBrilho[canal.porta];
+  uint8_t planos[8];
+  for (uint8_t b = 0; b < 8; b++) {
+    planos[b] = (ciclo & (1 << b)) ? (porta.planos[b] | canal.bit) : (porta.planos[b] & ~canal.bit);
+  }
+  noInterrupts(); // Os 8 planos mudam juntos: nenhum ciclo mistura o brilho antigo e o novo.
+  for (uint8_t b = 0; b < 8; b++) porta.planos[b] = planos[b];
+  interrupts();
+}
+
+static void liberarPorta(CanalBrilho& canal) {
+  noInterrupts();
+  PortaBrilho& porta = portasBrilho[canal.porta];
+  porta.mascara &= ~canal.bit;
+  for (uint8_t b = 0; b < 8; b++) porta.planos[b] &= ~canal.bit;
+  interrupts();
+}
+
+// Encontra o canal do pino, ou reserva um canal livre para ele. Retorna nullptr se não houver canais livres.
+static CanalBrilho* canalDoPino(uint8_t pino) {
+  iniciarCanais();
+  CanalBrilho* livre = nullptr;
+  for (uint8_t i = 0; i < GC_CANAIS_BRILHO; i++) {
+    if (canais[i].pino == pino) return &canais[i];
+    if (canais[i].pino == CANAL_LIVRE && livre == nullptr) livre = &canais[i];
+  }
+  if (livre == nullptr) {
+    Serial.println("Erro: Todos os canais de brilho estão em uso.");
+    return nullptr;
+  }
+  pararPadrao(pino); // O brilho substitui um padrão em execução no pino...
+  if (pino == ledPin) piscarAtivo = false; // ...e o piscarLed.
+  digitalWrite(pino, LOW);
+  pinMode(pino, OUTPUT);
+  livre->pino = pino;
+  livre->brilho = 0;
+  livre->emFade = false;
+  associarPorta(*livre);
+  if (canaisEmUso == 0) iniciarTimer();
+  aplicarBrilho(*livre);
+  canaisEmUso++;
+  return livre;
+}
+
+void pararBrilho(uint8_t pino) {
+  if (!canaisIniciados) return;
+  for (uint8_t i = 0; i < GC_CANAIS_BRILHO; i++) {
+    if (canais[i].pino != pino) continue;
+    liberarPorta(canais[i]);
+    canais[i].pino = CANAL_LIVRE;
+    digitalWrite(pino, LOW);
+    if (--canaisEmUso == 0) pararTimer();
+  }
+}
+
+bool pinoLigado(uint8_t pino) {
+  if (canaisEmUso > 0) {
+    for (uint8_t i = 0; i < GC_CANAIS_BRILHO; i++) {
+      if (canais[i].pino == pino) return canais[i].brilho > 0;
+    }
+  }
+  return digitalRead(pino) == HIGH;
+}
+
+void atualizarBrilho() {
+  if (canaisEmUso == 0) return;
+  unsigned long agora = millis();
+  for (uint8_t i = 0; i < GC_CANAIS_BRILHO; i++) {
+    CanalBrilho& canal = canais[i];
+    if (canal.pino == CANAL_LIVRE || !canal.emFade) continue;
+    unsigned long decorrido = agora - canal.inicio;
+    uint8_t brilho = canal.para;
+    if (decorrido < canal.duracao) {
+      brilho = canal.de + (long)(canal.para - canal.de) * (long)decorrido / (long)canal.duracao;
+    } else {
+      canal.emFade = false;
+    }
+    if (brilho != canal.brilho) { // Os planos só são recalculados quando o brilho muda.
+      canal.brilho = brilho;
+      aplicarBrilho(canal);
+    }
+  }
+}
+
+// Converte um brilho do comando (0 a 255). Retorna false se for inválido.
+static bool lerBrilho(const char* texto, uint8_t& brilho) {
+  char* fim;
+  long valor = strtol(texto, &fim, 10);
+  if (*fim != '\0' || valor < 0 || valor > 255) {
+    Serial.print("Erro: Brilho inválido: ");
+    Serial.print(texto);
+    Serial.println(" (use de 0 a 255).");
+    return false;
+  }
+  brilho = valor;
+  return true;
+}
+
+static bool lerPino(const char* texto, uint8_t& pino) {
+  char* fim;
+  long valor = strtol(texto, &fim, 10);
+  if (*fim != '\0' || valor < 0 || valor >= CANAL_LIVRE) {
+    Serial.print("Erro: Pino inválido: ");
+    Serial.println(texto);
+    return false;
+  }
+  pino = valor;
+  return true;
+}
+
+static void informarBrilho() {
+  Serial.print("Canais de brilho em uso: ");
+  Serial.print(canaisEmUso);
+  Serial.print(", portas: ");
+  Serial.print(numPortasBrilho);
+  Serial.print(", intervalos estourados: ");
+  Serial.print(intervalosEstourados);
+  Serial.println('.');
+}
+
+// Trata o comando "brilho".
+static void tratarBrilho(Comando comando) {
+  if (comando.numValores == 0) {
+    informarBrilho();
+    return;
+  }
+  uint8_t pino, brilho;
+  if (comando.numValores != 2) {
+    Serial.println("Erro: O comando 'brilho' espera 2 parâmetros: <pino> <0-255>.");
+    return;
+  }
+  if (!lerPino(comando.valores[0], pino) || !lerBrilho(comando.valores[1], brilho)) return;
+  CanalBrilho* canal = canalDoPino(pino);
+  if (canal == nullptr) return;
+  canal->emFade = false;
+  canal->brilho = brilho;
+  aplicarBrilho(*canal);
+}
+REGISTRAR_COMANDO("brilho", tratarBrilho, "<pino> <0-255>");
+
+// Trata o comando "fade".
+static void tratarFade(Comando comando) {
+  uint8_t pino, de, para;
+  if (comando.numValores != 4) {
+    Serial.println("Erro: O comando 'fade' espera 4 parâmetros: <pino> <de> <para> <ms>.");
+    return;
+  }
+  if (!lerPino(comando.valores[0], pino) || !lerBrilho(comando.valores[1], de) || !lerBrilho(comando.valores[2], para)) return;
+  long duracao = comando.valores[3].toInt();
+  if (duracao <= 0 || (unsigned long)duracao > GC_DURACAO_MAXIMA_FADE) {
+    Serial.print("Erro: A duração do fade deve ser de 1 a ");
+    Serial.print(GC_DURACAO_MAXIMA_FADE);
+    Serial.println(" ms.");
+    return;
+  }
+  CanalBrilho* canal = canalDoPino(pino);
+  if (canal == nullptr) return;
+  canal->de = de;
+  canal->para = para;
+  canal->inicio = millis();
+  canal->duracao = duracao;
+  canal->emFade = true;
+  canal->brilho = de;
+  aplicarBrilho(*canal);
+}
+REGISTRAR_COMANDO("fade", tratarFade, "<pino> <de> <para> <ms>");
+
+#else
+void pararBrilho(uint8_t) {}
+
+void atualizarBrilho() {}
+
+bool pinoLigado(uint8_t pino) {
+  return digitalRead(pino) == HIGH;
+}
+
+// Os comandos existem (e aparecem na ajuda), mas são recusados.
+static void recusarSemTimer() {
+#if GC_BRILHO
+  Serial.println("Erro: O controle de brilho precisa do Timer2 (placas AVR).");
+#else
+  Serial.println("Erro: O controle de brilho está desativado (compile com -DGC_BRILHO=1).");
+#endif
+}
+
+static void tratarBrilho(Comando) {
+  recusarSemTimer();
+}
+REGISTRAR_COMANDO("brilho", tratarBrilho, "<pino> <0-255>");
+
+static void tratarFade(Comando) {
+  recusarSemTimer();
+}
+REGISTRAR_COMANDO("fade", tratarFade, "<pino> <de> <para> <ms>");
+#endif
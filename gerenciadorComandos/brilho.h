@@ -0,0 +1,70 @@
+/*
+ * brilho.h
+ *
+ * Descrição:
+ * Controle de brilho (0 a 255) de LEDs em qualquer pino digital, inclusive nos pinos sem PWM
+ * de hardware, com os comandos:
+ *     brilho <pino> <0-255>           Define o brilho do pino.
+ *     fade <pino> <de> <para> <ms>    Varia o brilho de 'de' até 'para' em 'ms' milissegundos (até 1 hora).
+ *     brilho                          Informa os canais em uso e o tempo gasto pela interrupção.
+ *
+ * Funcionalidade Principal:
+ * Modulação por ângulo de bit (BAM): cada ciclo é dividido em 8 intervalos, de 1, 2, 4, ... 128
+ * unidades, e no intervalo do bit 'b' cada pino fica ligado se o bit 'b' do seu brilho for 1.
+ * São apenas 8 interrupções por ciclo (contra 256 de um PWM por software), e o ciclo de
+ * 4,08ms (245Hz) não é percebido como cintilação.
+ * O brilho passa por uma tabela de correção (curva de luminosidade CIE 1931) calculada na
+ * compilação, para que os passos de brilho pareçam iguais ao olho.
+ *
+ * Nas placas AVR a modulação usa a interrupção de comparação do Timer2. Os pinos são agrupados
+ * por porta do microcontrolador, e para cada porta são guardados os 8 "planos de bit" (o valor
+ * da porta em cada intervalo), recalculados fora da interrupção quando um brilho muda. Assim a
+ * interrupção faz uma única escrita por porta, independentemente do número de canais, e o seu
+ * custo é limitado pelo número de portas. Ela deve terminar dentro do menor intervalo (16us):
+ * o comando "brilho" informa quantas vezes isso não aconteceu (intervalos estourados).
+ * Enquanto houver canais em uso, o Timer2 deixa de estar disponível para analogWrite() nos pinos 3 e 11;
+ * a configuração anterior do Timer2 é restaurada quando o último canal é liberado.
+ * Nas demais placas o loop() não consegue manter os intervalos de 16us, e os comandos são recusados.
+ *
+ * O módulo é opcional (GC_BRILHO): sem ele, os comandos "brilho" e "fade" são recusados.
+ *
+ * Exemplo de Comando:
+ * "brilho 13 40" (LED com brilho baixo)
+ * "fade 13 0 255 2000" (acende o LED gradualmente em 2 segundos)
+ */
+
+#ifndef BRILHO_H
+#define BRILHO_H
+
+#include <Arduino.h>
+
+// Ativa o controle de brilho. Desativado por padrão, pois define a interrupção TIMER2_COMPA (placas AVR),
+// também definida por tone() (o programa não seria montado).
+// A biblioteca é compilada separadamente do sketch: ative nas opções de compilação (-DGC_BRILHO=1).
+#ifndef GC_BRILHO
+#define GC_BRILHO 0
+#endif
+
+// Pinos com brilho controlado ao mesmo tempo (até 32).
+#ifndef GC_CANAIS_BRILHO
+#define GC_CANAIS_BRILHO 8
+#endif
+
+// Maior duração aceita pelo comando "fade" (em milissegundos). O cálculo do fade, em 32 bits,
+// multiplica a diferença de brilho (até 255) pelo tempo decorrido: até cerca de 2,3 horas.
+#ifndef GC_DURACAO_MAXIMA_FADE
+#define GC_DURACAO_MAXIMA_FADE 3600000UL
+#endif
+
+// Encerra o controle de brilho do pino, se houver (o pino fica desligado).
+void pararBrilho(uint8_t pino);
+
+// Estado do pino para eventos e telemetria: com brilho controlado, ligado se o brilho pedido
+// for maior que 0 (ler o pino amostraria a modulação, que muda centenas de vezes por segundo);
+// sem brilho controlado, o valor de digitalRead().
+bool pinoLigado(uint8_t pino);
+
+// Avança os fades em execução. Deve ser chamada a cada loop().
+void atualizarBrilho();
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * configuracao.cpp
+ *
+ * Descrição:
+ * Gravação e restauração da configuração persistente na EEPROM.
+ * Veja configuracao.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "gerenciadorComandos.h"
+#include "parametros.h"
+#include "configuracao.h"
+#include "modbusRTU.h" // crc16Modbus.
+#include "diario.h"
+
+static const uint16_t ASSINATURA_CONFIGURACAO = 0x4743; // "GC": identifica um bloco gravado por esta biblioteca.
+
+// Cabeçalho do bloco gravado na EEPROM, seguido de um int16 por parâmetro persistente.
+struct CabecalhoConfiguracao {
+    uint16_t assinatura;   // ASSINATURA_CONFIGURACAO.
+    uint8_t versao;        // GC_VERSAO_CONFIGURACAO.
+    uint8_t numValores;    // Quantidade de valores gravados.
+    uint16_t esquema;      // Hash dos nomes dos parâmetros gravados (detecta mudanças na tabela).
+    uint16_t crc;          // CRC16 dos valores e da geração.
+    uint8_t geracao;       // Incrementada a cada gravação (nunca 0); identifica as páginas do diário posteriores a ela.
+};
+
+static uint8_t geracaoAtual = 0; // Geração da configuração válida na EEPROM (0 = nenhuma).
+
+// CRC do bloco: cobre a geração para que um cabeçalho gravado pela metade seja recusado.
+static uint16_t calcularCrc(const int16_t* valores, uint8_t tamanho, uint8_t geracao) {
+  return crc16Modbus(&geracao, 1, crc16Modbus((const uint8_t*)valores, tamanho));
+}
+
+// Calcula a assinatura do esquema e conta os parâmetros persistentes.
+static uint16_t calcularEsquema(uint8_t& numValores) {
+  uint16_t esquema = 0;
+  numValores = 0;
+  for (uint8_t i = 0; i < numParametros(); i++) {
+    ParametroInfo parametro = descricaoParametro(i);
+    if (!parametro.persistente) continue;
+    esquema = (esquema << 3 | esquema >> 13) ^ parametro.hash; // Depende dos nomes e da ordem.
+    numValores++;
+  }
+  return esquema;
+}
+
+// Copia para 'valores' os valores atuais dos parâmetros persistentes, na ordem da tabela.
+static void lerValoresAtuais(int16_t* valores) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < numParametros(); i++) {
+    if (descricaoParametro(i).persistente) valores[n++] = lerParametro(i);
+  }
+}
+
+// O bloco de configuração (cabeçalho e um valor por parâmetro) precisa caber antes do diário.
+static_assert(GC_ENDERECO_CONFIGURACAO + sizeof(CabecalhoConfiguracao) + GC_NUM_PARAMETROS * sizeof(int16_t) <= GC_ENDERECO_DIARIO,
+              "A configuração invade a área do diário (GC_ENDERECO_DIARIO)");
+
+void iniciarEeprom() {
+#if defined(ESP8266) || defined(ESP32)
+  static bool iniciada = false;
+  if (iniciada) return;
+  EEPROM.begin(GC_TAMANHO_EEPROM); // Copia a área da flash para a RAM; sem isto as leituras e gravações não têm efeito.
+  iniciada = true;
+#endif
+}
+
+void gravarByteEeprom(int endereco, uint8_t valor) {
+#if defined(__AVR__)
+  EEPROM.update(endereco, valor); // 'update' só grava bytes diferentes.
+#else
+  if (EEPROM.read(endereco) != valor) EEPROM.write(endereco, valor); // 'update' não existe em todas as placas (ex: ESP8266).
+#endif
+}
+
+void confirmarEeprom() {
+#if defined(ESP8266) || defined(ESP32)
+  EEPROM.commit(); // Nestas placas a EEPROM é emulada na flash e só é gravada no commit.
+#endif
+}
+
+static void lerEeprom(int endereco, void* destino, uint8_t tamanho) {
+  uint8_t* bytes = (uint8_t*)destino;
+  for (uint8_t i = 0; i < tamanho; i++) bytes[i] = EEPROM.read(endereco + i);
+}
+
+static void gravarEeprom(int endereco, const void* origem, uint8_t tamanho) {
+  const uint8_t* bytes = (const uint8_t*)origem;
+  for (uint8_t i = 0; i < tamanho; i++) gravarByteEeprom(endereco + i, bytes[i]);
+}
+
+void salvarConfiguracao() {
+  CabecalhoConfiguracao cabecalho;
+  cabecalho.assinatura = ASSINATURA_CONFIGURACAO;
+  cabecalho.versao = GC_VERSAO_CONFIGURACAO;
+  cabecalho.esquema = calcularEsquema(cabecalho.numValores);
+
+  // A nova geração parte da gravada (mesmo que inválida), para não repetir a de páginas antigas do diário.
+  CabecalhoConfiguracao anterior;
+  lerEeprom(GC_ENDERECO_CONFIGURACAO, &anterior, sizeof(anterior));
+  cabecalho.geracao = (anterior.assinatura == ASSINATURA_CONFIGURACAO ? anterior.geracao : geracaoAtual) + 1;
+  if (cabecalho.geracao == 0) cabecalho.geracao = 1; // 0 é reservado para "sem configuração".
+
+  int16_t valores[GC_NUM_PARAMETROS]; // Os persistentes são no máximo todos os parâmetros.
+  uint8_t tamanho = cabecalho.numValores * sizeof(int16_t);
+  lerValoresAtuais(valores);
+  cabecalho.crc = calcularCrc(valores, tamanho, cabecalho.geracao);
+
+  // Os valores são gravados antes do cabeçalho: se a placa for desligada no meio da gravação,
+  // o CRC antigo não confere com os valores novos e a configuração é recusada na próxima inicialização.
+  // Com o cabeçalho, a geração muda e as páginas antigas do diário deixam de valer no mesmo passo.
+  gravarEeprom(GC_ENDERECO_CONFIGURACAO + sizeof(cabecalho), valores, tamanho);
+  gravarEeprom(GC_ENDERECO_CONFIGURACAO, &cabecalho, sizeof(cabecalho));
+  confirmarEeprom();
+  geracaoAtual = cabecalho.geracao;
+}
+
+uint8_t geracaoConfiguracao() {
+  return geracaoAtual;
+}
+
+bool carregarConfiguracao() {
+  iniciarEeprom();
+  CabecalhoConfiguracao cabecalho;
+  lerEeprom(GC_ENDERECO_CONFIGURACAO, &cabecalho, sizeof(cabecalho));
+
+  uint8_t numValores;
+  uint16_t esquema = calcularEsquema(numValores);
+  if (cabecalho.assinatura != ASSINATURA_CONFIGURACAO || cabecalho.versao != GC_VERSAO_CONFIGURACAO ||
+      cabecalho.numValores != numValores || cabecalho.esquema != esquema) {
+    return false; // EEPROM vazia, de outro programa ou de outra versão da tabela de parâmetros.
+  }
+
+  int16_t valores[GC_NUM_PARAMETROS];
+  uint8_t tamanho = numValores * sizeof(int16_t);
+  lerEeprom(GC_ENDERECO_CONFIGURACAO + sizeof(cabecalho), valores, tamanho);
+  if (cabecalho.geracao == 0 || calcularCrc(valores, tamanho, cabecalho.geracao) != cabecalho.crc) {
+    return false; // Gravação incompleta ou corrompida.
+  }
+  geracaoAtual = cabecalho.geracao;
+
+  // Restaura na ordem da tabela, sem a verificação de "somente leitura" (o estado do piscar também é restaurado).
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < numParametros(); i++) {
+    if (descricaoParametro(i).persistente) escreverParametro(i, valores[n++]);
+  }
+  if (piscarAtivo) tempoAnteriorLigado = millis(); // Recomeça a contagem de tempo do piscar restaurado.
+  return true;
+}
+
+// Trata o comando "salvar".
+static void tratarSalvar(Comando comando) {
+  // O comando "salvar" não espera nenhum parâmetro.
+  if (comando.numValores != 0) {
+    Serial.println("Erro: O comando 'salvar' não espera nenhum parâmetro.");
+    return;
+  }
+  salvarConfiguracao(); // Grava o bloco de configuração (com versão e CRC) na EEPROM.
+  compactarDiario();    // O diário passa a partir dos mesmos valores, para não sobrepor os salvos com alterações antigas.
+  Serial.println("Configuração salva.");
+}
+REGISTRAR_COMANDO("salvar", tratarSalvar, "", 250); // Gravação na EEPROM: cerca de 3,3ms por byte alterado.
+
+// Trata o comando "carregar".
+static void tratarCarregar(Comando comando) {
+  // O comando "carregar" não espera nenhum parâmetro.
+  if (comando.numValores != 0) {
+    Serial.println("Erro: O comando 'carregar' não espera nenhum parâmetro.");
+    return;
+  }
+  if (carregarConfiguracao()) { // Só aplica a configuração se o CRC e a versão conferirem.
+    compactarDiario(); // Os valores carregados substituem as alterações anteriores do diário.
+    Serial.println("Configuração carregada.");
+  } else {
+    Serial.println("Erro: Nenhuma configuração válida gravada.");
+  }
+}
+REGISTRAR_COMANDO("carregar", tratarCarregar, "");
@@ -0,0 +1,57 @@
+/*
+ * configuracao.h
+ *
+ * Descrição:
+ * Configuração persistente do gerenciador de comandos. Os parâmetros marcados
+ * como persistentes no registro de parâmetros (parametros.cpp), incluindo o estado
+ * do piscar, são guardados na EEPROM e restaurados na inicialização da placa,
+ * para que ela volte a operar sem precisar ser reconfigurada pelo computador.
+ *
+ * Funcionalidade Principal:
+ * A configuração é gravada como um bloco único (snapshot) com assinatura, versão,
+ * assinatura do esquema (hash dos nomes dos parâmetros salvos) e CRC16. Um bloco
+ * corrompido, de outra versão ou de uma tabela de parâmetros diferente é ignorado,
+ * e os valores padrão do programa são mantidos.
+ *
+ * Utilização:
+ * 1. Chame 'carregarConfiguracao' no setup(), depois de configurar os pinos.
+ * 2. Use os comandos "salvar" e "carregar" pela Serial.
+ * Nas placas ESP8266/ESP32, 'carregarConfiguracao' também reserva a EEPROM emulada
+ * (GC_TAMANHO_EEPROM bytes), e cada gravação é efetivada com EEPROM.commit().
+ */
+
+#ifndef CONFIGURACAO_H
+#define CONFIGURACAO_H
+
+#include <Arduino.h>
+
+// Endereço da EEPROM em que a configuração é gravada.
+#ifndef GC_ENDERECO_CONFIGURACAO
+#define GC_ENDERECO_CONFIGURACAO 0
+#endif
+
+// Versão do formato da configuração. Deve ser incrementada quando o formato gravado mudar.
+#define GC_VERSAO_CONFIGURACAO 2
+
+// Bytes de EEPROM usados pela configuração e pelo diário (diario.h).
+// Nas placas ESP8266/ESP32 a EEPROM é emulada na flash, e este é o tamanho reservado por EEPROM.begin().
+#ifndef GC_TAMANHO_EEPROM
+#define GC_TAMANHO_EEPROM 512
+#endif
+
+// Acesso à EEPROM comum a todas as placas (também usado pelo diário).
+void iniciarEeprom();                               // Reserva a EEPROM emulada (ESP); chamada por carregarConfiguracao().
+void gravarByteEeprom(int endereco, uint8_t valor); // Grava apenas se o valor for diferente do gravado.
+void confirmarEeprom();                             // Efetiva as gravações anteriores (commit nas placas ESP).
+
+// Grava os parâmetros persistentes na EEPROM. Apenas os bytes alterados são regravados.
+void salvarConfiguracao();
+
+// Restaura os parâmetros persistentes da EEPROM. Retorna false se não houver configuração válida.
+bool carregarConfiguracao();
+
+// Geração da configuração carregada ou salva (0 se não houver uma configuração válida).
+// Cada "salvar" usa uma nova geração; o diário só aplica as páginas gravadas na mesma geração.
+uint8_t geracaoConfiguracao();
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * diario.cpp
+ *
+ * Descrição:
+ * Diário de alterações de parâmetros na EEPROM, com nivelamento de desgaste.
+ * Veja diario.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "gerenciadorComandos.h"
+#include "parametros.h"
+#include "configuracao.h" // Acesso à EEPROM e geração da configuração salva.
+#include "diario.h"
+
+// Formato de uma página: cabeçalho (sequência de 16 bits, geração da configuração e CRC-8) seguido de registros.
+static const uint8_t TAMANHO_CABECALHO = 4;
+static const uint8_t TAMANHO_REGISTRO = 4; // Índice do parâmetro, valor (2 bytes) e CRC-8.
+static const uint8_t REGISTROS_POR_PAGINA = (GC_TAMANHO_PAGINA_DIARIO - TAMANHO_CABECALHO) / TAMANHO_REGISTRO;
+static const uint8_t REGISTRO_VAZIO = 0xFF; // Valor da EEPROM apagada.
+
+// Etapas das gravações em segundo plano.
+enum EtapaDiario {
+  DIARIO_OCIOSO,         // Aguardando alterações.
+  DIARIO_APAGANDO,       // Compactação: apagando os registros da próxima página.
+  DIARIO_COPIANDO,       // Compactação: copiando os valores atuais para a próxima página.
+  DIARIO_ATIVANDO        // Compactação: gravando o cabeçalho, que torna a página ativa.
+};
+
+static uint16_t alteracoesPendentes = 0;   // Um bit por parâmetro alterado e ainda não gravado.
+static_assert(GC_NUM_PARAMETROS <= sizeof(alteracoesPendentes) * 8,
+              "Mais parâmetros que bits em alteracoesPendentes (diario.cpp)");
+static unsigned long ultimaAlteracao = 0;  // Instante (millis()) da última alteração.
+static bool compactacaoPedida = false;
+static EtapaDiario etapa = DIARIO_OCIOSO;
+
+static uint8_t paginaAtiva = 0;
+static uint16_t sequenciaAtiva = 0;
+static uint8_t proximoRegistro = 0;        // Posição livre na página ativa (REGISTROS_POR_PAGINA = cheia).
+static bool paginaValida = false;          // Se existe uma página ativa (EEPROM já formatada).
+
+static_assert(GC_ENDERECO_DIARIO + GC_PAGINAS_DIARIO * GC_TAMANHO_PAGINA_DIARIO <= GC_TAMANHO_EEPROM,
+              "O diário não cabe em GC_TAMANHO_EEPROM");
+
+static uint8_t posicaoCompactacao = 0;     // Progresso da etapa atual da compactação.
+static uint8_t parametroCompactacao = 0;
+static uint8_t registrosCompactacao = 0;
+
+// Bytes da gravação em andamento, gravados um por vez.
+static uint8_t bytesGravacao[TAMANHO_REGISTRO];
+static uint8_t tamanhoGravacao = 0;
+static uint8_t posicaoGravacao = 0;
+static int enderecoGravacao = 0;
+
+// CRC-8 (polinômio 0x07), bit a bit: poucos bytes por registro.
+static uint8_t crc8(const uint8_t* dados, uint8_t tamanho) {
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < tamanho; i++) {
+    crc ^= dados[i];
+    for (uint8_t bit = 0; bit < 8; bit++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+static int enderecoPagina(uint8_t pagina) {
+  return GC_ENDERECO_DIARIO + pagina * GC_TAMANHO_PAGINA_DIARIO;
+}
+
+static int enderecoRegistro(uint8_t pagina, uint8_t registro) {
+  return enderecoPagina(pagina) + TAMANHO_CABECALHO + registro * TAMANHO_REGISTRO;
+}
+
+// Parâmetros que entram no diário: persistentes, graváveis e guardados em variável.
+// Os demais (estado do LED e do piscar) continuam sendo salvos apenas pelo comando "salvar".
+static bool parametroNoDiario(uint8_t indice) {
+  ParametroInfo parametro = descricaoParametro(indice);
+  return parametro.persistente && !parametro.somenteLeitura && parametro.variavel != nullptr;
+}
+
+// Se a EEPROM terminou a gravação anterior (nas placas AVR a gravação de um byte leva cerca de 3,3ms).
+static bool eepromLivre() {
+#if defined(__AVR__)
+  return eeprom_is_ready();
+#else
+  return true;
+#endif
+}
+
+static void prepararRegistro(int endereco, uint8_t indice) {
+  int valor = lerParametro(indice);
+  bytesGravacao[0] = indice;
+  bytesGravacao[1] = valor & 0xFF;
+  bytesGravacao[2] = (valor >> 8) & 0xFF;
+  bytesGravacao[3] = crc8(bytesGravacao, 3); // Gravado por último: um registro incompleto não confere.
+  enderecoGravacao = endereco;
+  tamanhoGravacao = TAMANHO_REGISTRO;
+  posicaoGravacao = 0;
+}
+
+static void prepararCabecalho(int endereco, uint16_t sequencia) {
+  bytesGravacao[0] = sequencia & 0xFF;
+  bytesGravacao[1] = sequencia >> 8;
+  bytesGravacao[2] = geracaoConfiguracao();
+  bytesGravacao[3] = crc8(bytesGravacao, 3);
+  enderecoGravacao = endereco;
+  tamanhoGravacao = TAMANHO_CABECALHO;
+  posicaoGravacao = 0;
+}
+
+void registrarAlteracao(uint8_t indiceParametro) {
+  if (indiceParametro >= sizeof(alteracoesPendentes) * 8 || !parametroNoDiario(indiceParametro)) return;
+  alteracoesPendentes |= (uint16_t)1 << indiceParametro;
+  ultimaAlteracao = millis(); // Alterações seguidas adiam a gravação e são agrupadas.
+}
+
+void compactarDiario() {
+  compactacaoPedida = true;
+}
+
+void recuperarDiario() {
+  iniciarEeprom();
+
+  // Encontra a página ativa lendo apenas os cabeçalhos: a de maior sequência com CRC válido.
+  paginaValida = false;
+  uint8_t geracaoPagina = 0;
+  for (uint8_t pagina = 0; pagina < GC_PAGINAS_DIARIO; pagina++) {
+    uint8_t cabecalho[TAMANHO_CABECALHO];
+    for (uint8_t i = 0; i < TAMANHO_CABECALHO; i++) cabecalho[i] = EEPROM.read(enderecoPagina(pagina) + i);
+    if (crc8(cabecalho, 3) != cabecalho[3]) continue;
+    uint16_t sequencia = cabecalho[0] | ((uint16_t)cabecalho[1] << 8);
+    if (!paginaValida || (int16_t)(sequencia - sequenciaAtiva) > 0) { // Comparação que tolera a volta do contador.
+      paginaAtiva = pagina;
+      sequenciaAtiva = sequencia;
+      geracaoPagina = cabecalho[2];
+      paginaValida = true;
+    }
+  }
+  if (!paginaValida) { // EEPROM nunca usada pelo diário: a primeira gravação cria uma página.
+    compactacaoPedida = true;
+    return;
+  }
+  if (geracaoPagina != geracaoConfiguracao()) {
+    // Página anterior ao último "salvar" (desligada antes da compactação): os registros dela são antigos
+    // e não podem sobrepor a configuração salva. A próxima gravação começa uma página da geração atual.
+    proximoRegistro = REGISTROS_POR_PAGINA;
+    compactacaoPedida = true;
+    return;
+  }
+
+  // Aplica, em ordem, os registros da página ativa até o primeiro espaço vazio.
+  proximoRegistro = 0;
+  while (proximoRegistro < REGISTROS_POR_PAGINA) {
+    uint8_t registro[TAMANHO_REGISTRO];
+    int endereco = enderecoRegistro(paginaAtiva, proximoRegistro);
+    for (uint8_t i = 0; i < TAMANHO_REGISTRO; i++) registro[i] = EEPROM.read(endereco + i);
+    if (registro[0] == REGISTRO_VAZIO) break;
+    proximoRegistro++; // Um registro incompleto (CRC inválido) é pulado, mas ocupa a sua posição.
+    if (crc8(registro, 3) != registro[3] || registro[0] >= numParametros()) continue;
+    escreverParametro(registro[0], (int16_t)(registro[1] | ((uint16_t)registro[2] << 8)));
+  }
+}
+
+// Avança a compactação: apaga a próxima página, copia os valores atuais e grava o cabeçalho.
+static void avancarCompactacao() {
+  uint8_t proximaPagina = paginaValida ? (paginaAtiva + 1) % GC_PAGINAS_DIARIO : paginaAtiva;
+
+  if (etapa == DIARIO_APAGANDO) {
+    if (posicaoCompactacao < REGISTROS_POR_PAGINA * TAMANHO_REGISTRO) {
+      int endereco = enderecoRegistro(proximaPagina, 0) + posicaoCompactacao++;
+      gravarByteEeprom(endereco, REGISTRO_VAZIO); // Bytes já apagados não são regravados.
+      return;
+    }
+    etapa = DIARIO_COPIANDO;
+    parametroCompactacao = 0;
+    registrosCompactacao = 0;
+  }
+
+  if (etapa == DIARIO_COPIANDO) {
+    while (parametroCompactacao < numParametros() && !parametroNoDiario(parametroCompactacao)) parametroCompactacao++;
+    if (parametroCompactacao < numParametros() && registrosCompactacao < REGISTROS_POR_PAGINA) {
+      prepararRegistro(enderecoRegistro(proximaPagina, registrosCompactacao++), parametroCompactacao++);
+      return;
+    }
+    etapa = DIARIO_ATIVANDO;
+    prepararCabecalho(enderecoPagina(proximaPagina), sequenciaAtiva + 1); // A página só passa a valer com o cabeçalho.
+    return;
+  }
+
+  // DIARIO_ATIVANDO: o cabeçalho foi gravado, a nova página é a ativa.
+  paginaAtiva = proximaPagina;
+  sequenciaAtiva++;
+  paginaValida = true;
+  proximoRegistro = registrosCompactacao;
+  etapa = DIARIO_OCIOSO;
+}
+
+void atualizarDiario() {
+  // Só grava com a EEPROM livre e sem bytes chegando pela Serial (tempo ocioso do loop()).
+  if (!eepromLivre() || Serial.available() > 0) return;
+
+  if (posicaoGravacao < tamanhoGravacao) { // Um byte por chamada: a gravação não bloqueia o loop().
+    gravarByteEeprom(enderecoGravacao + posicaoGravacao, bytesGravacao[posicaoGravacao]);
+    posicaoGravacao++;
+    if (posicaoGravacao == tamanhoGravacao) confirmarEeprom();
+    return;
+  }
+
+  if (etapa != DIARIO_OCIOSO) {
+    avancarCompactacao();
+    return;
+  }
+
+  if (compactacaoPedida || (alteracoesPendentes != 0 && proximoRegistro >= REGISTROS_POR_PAGINA)) {
+    // Página cheia (ou "salvar"): todos os valores atuais vão para a próxima página, então as pendências são atendidas.
+    compactacaoPedida = false;
+    alteracoesPendentes = 0;
+    etapa = DIARIO_APAGANDO;
+    posicaoCompactacao = 0;
+    return;
+  }
+
+  if (alteracoesPendentes != 0 && millis() - ultimaAlteracao >= GC_ATRASO_DIARIO) {
+    uint8_t indice = 0;
+    while (!(alteracoesPendentes & ((uint16_t)1 << indice))) indice++;
+    alteracoesPendentes &= ~((uint16_t)1 << indice);
+    prepararRegistro(enderecoRegistro(paginaAtiva, proximoRegistro++), indice);
+  }
+}
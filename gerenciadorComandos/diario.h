@@ -0,0 +1,69 @@
+/*
+ * diario.h
+ *
+ * Descrição:
+ * Diário (journal) de alterações de parâmetros na EEPROM, com nivelamento de desgaste.
+ * Cada "definir" de um parâmetro persistente é gravado automaticamente, sem regravar
+ * a configuração inteira e sem bloquear o tratamento dos comandos.
+ *
+ * Funcionalidade Principal:
+ * A área do diário é dividida em páginas usadas em rodízio. As alterações são
+ * acrescentadas como registros de 4 bytes (parâmetro, valor e CRC-8) na página ativa.
+ * Quando a página enche, a compactação copia os valores atuais para a próxima página
+ * e só então grava o cabeçalho dela (com número de sequência), tornando-a a página ativa.
+ * Assim as gravações se espalham por todas as páginas, e um desligamento no meio de
+ * uma gravação nunca deixa a configuração inconsistente.
+ *
+ * O cabeçalho da página também guarda a geração da configuração salva (configuracao.h).
+ * Se a placa for desligada depois de um "salvar" e antes da compactação, a página ativa
+ * é de uma geração anterior e os seus registros não são aplicados sobre a configuração nova.
+ *
+ * As gravações são agrupadas (várias alterações seguidas do mesmo parâmetro geram um
+ * único registro) e feitas um byte por vez, apenas quando a EEPROM está livre e não há
+ * bytes chegando pela Serial, para não atrasar o loop().
+ *
+ * Na inicialização, apenas os cabeçalhos das páginas e os registros da página ativa são lidos.
+ *
+ * Utilização:
+ * 1. Chame 'recuperarDiario' no setup(), depois de 'carregarConfiguracao'.
+ * 2. Chame 'atualizarDiario' a cada execução do loop().
+ */
+
+#ifndef DIARIO_H
+#define DIARIO_H
+
+#include <Arduino.h>
+
+// Endereço da EEPROM em que começa o diário (depois do bloco de configuracao.h).
+#ifndef GC_ENDERECO_DIARIO
+#define GC_ENDERECO_DIARIO 64
+#endif
+
+// Número de páginas usadas em rodízio e tamanho (em bytes) de cada página.
+// Uma página deve comportar um registro por parâmetro do diário, com folga para novas alterações.
+#ifndef GC_PAGINAS_DIARIO
+#define GC_PAGINAS_DIARIO 4
+#endif
+#ifndef GC_TAMANHO_PAGINA_DIARIO
+#define GC_TAMANHO_PAGINA_DIARIO 64
+#endif
+
+// Tempo (em milissegundos) sem novas alterações antes de gravá-las, agrupando alterações seguidas.
+#ifndef GC_ATRASO_DIARIO
+#define GC_ATRASO_DIARIO 2000
+#endif
+
+// Registra que um parâmetro foi alterado. A gravação acontece depois, em segundo plano.
+// Apenas parâmetros persistentes, graváveis e guardados em variável entram no diário.
+void registrarAlteracao(uint8_t indiceParametro);
+
+// Agenda a cópia de todos os valores atuais para uma nova página (usado pelo comando "salvar").
+void compactarDiario();
+
+// Aplica as alterações gravadas na página ativa. Deve ser chamada no setup().
+void recuperarDiario();
+
+// Executa um passo das gravações pendentes. Deve ser chamada a cada loop().
+void atualizarDiario();
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ * etapasDespacho.cpp
+ *
+ * Descrição:
+ * Dados das etapas de despacho. Veja etapasDespacho.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "etapasDespacho.h"
+
+Print* EtapaRegistro::saida = nullptr;
+
+EstatisticasDespacho estatisticasDespacho = {0, 0, 0, 0};
+
+ExcessosOrcamento excessosOrcamento = {0, nullptr, 0, 0};
+
+// Nas placas AVR, a seção .noinit não é zerada na inicialização: o valor sobrevive a um reinício
+// pelo watchdog (ou pelo botão de reset). A marca depende do ponteiro, o que evita aceitar o conteúdo
+// aleatório da RAM após ligar a placa.
+#if defined(__AVR__)
+#define GC_NAO_INICIALIZADA __attribute__((section(".noinit")))
+#else
+#define GC_NAO_INICIALIZADA
+#endif
+static const uint16_t MARCA_COMANDO = 0xA5C3;
+static const char* comandoEmExecucao GC_NAO_INICIALIZADA;
+static uint16_t marcaComandoEmExecucao GC_NAO_INICIALIZADA;
+
+void marcarComandoEmExecucao(const char* nome) {
+  comandoEmExecucao = nome;
+  marcaComandoEmExecucao = nome != nullptr ? (uint16_t)((uintptr_t)nome ^ MARCA_COMANDO) : 0;
+}
+
+void informarReinicioDuranteComando() {
+#if GC_WATCHDOG_COMANDOS && defined(__AVR__)
+  MCUSR = 0;      // Após um reinício pelo watchdog ele continua ativo: desliga antes que reinicie a placa de novo.
+  wdt_disable();
+#endif
+  if (comandoEmExecucao != nullptr && marcaComandoEmExecucao == (uint16_t)((uintptr_t)comandoEmExecucao ^ MARCA_COMANDO)) {
+    Serial.print("AVISO: A placa reiniciou durante o comando '");
+    Serial.print(comandoEmExecucao);
+    Serial.println("'.");
+  }
+  marcarComandoEmExecucao(nullptr);
+}
@@ -0,0 +1,188 @@
+/*
+ * etapasDespacho.h
+ *
+ * Descrição:
+ * Etapas executadas antes e depois da função de tratamento de cada comando
+ * (registro, estatísticas, limite de taxa, permissões, ...), sem alterar
+ * processarComando nem as funções de tratamento.
+ *
+ * Funcionalidade Principal:
+ * As etapas são escolhidas na compilação por GC_ETAPAS_DESPACHO, uma lista de tipos
+ * combinada por templates. Cada etapa é uma struct com duas funções estáticas:
+ *
+ *     static bool antes(const ComandoInfo& info, Comando& comando); // false = comando recusado.
+ *     static void depois(const ComandoInfo& info, const Comando& comando);
+ *
+ * As funções 'antes' são chamadas na ordem da lista, e as 'depois' na ordem inversa.
+ * Como tudo é resolvido na compilação, as etapas usadas são expandidas em volta da chamada
+ * da função de tratamento, e uma lista vazia não gera nenhum código.
+ * O padrão é apenas EtapaOrcamento, que mede o tempo de cada comando: custa duas leituras de
+ * micros() e duas chamadas a marcarComandoEmExecucao por comando (medicoes/medirRecepcao mede
+ * o custo). Para despachar sem nenhuma instrução a mais, e sem o orçamento, use a lista vazia
+ * (-DGC_ETAPAS_DESPACHO=).
+ *
+ * Utilização:
+ * Defina GC_ETAPAS_DESPACHO nas opções de compilação, por exemplo:
+ *     -DGC_ETAPAS_DESPACHO="EtapaEstatisticas,EtapaLimiteTaxa<50>"
+ */
+
+#ifndef ETAPAS_DESPACHO_H
+#define ETAPAS_DESPACHO_H
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+
+// Composição das etapas: a primeira da lista envolve todas as seguintes.
+template<typename... Etapas> struct EtapasDespacho;
+
+template<> struct EtapasDespacho<> { // Lista vazia: nada a fazer.
+    static inline bool antes(const ComandoInfo&, Comando&) { return true; }
+    static inline void depois(const ComandoInfo&, const Comando&) {}
+};
+
+template<typename Etapa, typename... Resto> struct EtapasDespacho<Etapa, Resto...> {
+    static inline bool antes(const ComandoInfo& info, Comando& comando) {
+        return Etapa::antes(info, comando) && EtapasDespacho<Resto...>::antes(info, comando); // Uma recusa interrompe a lista.
+    }
+    static inline void depois(const ComandoInfo& info, const Comando& comando) {
+        EtapasDespacho<Resto...>::depois(info, comando);
+        Etapa::depois(info, comando);
+    }
+};
+
+// Watchdog de hardware durante os comandos (apenas placas AVR): se uma função de tratamento
+// travar por mais de GC_WATCHDOG_TEMPO, a placa é reiniciada, e o nome do comando é informado
+// no próximo setup() por informarReinicioDuranteComando().
+// Não ative se o sketch já usa o watchdog para outra finalidade.
+#ifndef GC_WATCHDOG_COMANDOS
+#define GC_WATCHDOG_COMANDOS 0
+#endif
+#if GC_WATCHDOG_COMANDOS && defined(__AVR__)
+#include <avr/wdt.h>
+#ifndef GC_WATCHDOG_TEMPO
+#define GC_WATCHDOG_TEMPO WDTO_4S // Deve ser maior que o maior orçamento da tabela.
+#endif
+#endif
+
+// Orçamento de tempo: mede cada função de tratamento e informa as que excedem o orçamento do
+// comando (ComandoInfo::orcamento, ou GC_ORCAMENTO_PADRAO), com o nome do comando e o tempo gasto.
+struct ExcessosOrcamento {
+    unsigned int excessos;       // Execuções que excederam o orçamento.
+    const char* ultimoComando;   // Nome do último comando que excedeu o orçamento (nullptr = nenhum).
+    unsigned long ultimoTempo;   // Tempo gasto por ele, em milissegundos.
+    unsigned long inicio;        // Instante (micros()) em que o comando atual começou.
+};
+extern ExcessosOrcamento excessosOrcamento;
+
+// Comando em execução, preservado após um reinício (nas placas AVR a variável não é zerada na inicialização).
+void marcarComandoEmExecucao(const char* nome); // nullptr = nenhum comando em execução.
+
+// Informa (pela Serial) se a placa reiniciou durante um comando, por exemplo pelo watchdog.
+// Deve ser chamada no setup(), logo após Serial.begin().
+void informarReinicioDuranteComando();
+
+struct EtapaOrcamento {
+    static inline bool antes(const ComandoInfo& info, Comando&) {
+        marcarComandoEmExecucao(info.nome);
+#if GC_WATCHDOG_COMANDOS && defined(__AVR__)
+        wdt_enable(GC_WATCHDOG_TEMPO);
+#endif
+        excessosOrcamento.inicio = micros();
+        return true;
+    }
+    static inline void depois(const ComandoInfo& info, const Comando&) {
+        unsigned long tempo = (micros() - excessosOrcamento.inicio) / 1000;
+#if GC_WATCHDOG_COMANDOS && defined(__AVR__)
+        wdt_disable();
+#endif
+        marcarComandoEmExecucao(nullptr);
+        unsigned long limite = info.orcamento != 0 ? info.orcamento : GC_ORCAMENTO_PADRAO;
+        if (tempo <= limite) return;
+        excessosOrcamento.excessos++;
+        excessosOrcamento.ultimoComando = info.nome;
+        excessosOrcamento.ultimoTempo = tempo;
+        Serial.print("AVISO: O comando '");
+        Serial.print(info.nome);
+        Serial.print("' levou ");
+        Serial.print(tempo);
+        Serial.print("ms (orçamento: ");
+        Serial.print(limite);
+        Serial.println("ms).");
+    }
+};
+
+// Etapas usadas pelo gerenciador.
+#ifndef GC_ETAPAS_DESPACHO
+#define GC_ETAPAS_DESPACHO EtapaOrcamento
+#endif
+
+// Registro: escreve o nome de cada comando executado em uma porta de depuração (ex: Serial1).
+// Sem porta configurada (EtapaRegistro::saida = nullptr), nada é escrito.
+struct EtapaRegistro {
+    static Print* saida;
+    static inline bool antes(const ComandoInfo& info, Comando&) {
+        if (saida != nullptr) {
+            saida->print("> ");
+            saida->println(info.nome);
+        }
+        return true;
+    }
+    static inline void depois(const ComandoInfo&, const Comando&) {}
+};
+
+// Estatísticas: número de comandos executados e tempo das funções de tratamento (em microssegundos).
+struct EstatisticasDespacho {
+    unsigned long comandos;     // Comandos executados.
+    unsigned long tempoTotal;   // Soma dos tempos de execução.
+    unsigned long tempoMaximo;  // Maior tempo de execução.
+    unsigned long inicio;       // Instante (micros()) em que o comando atual começou.
+};
+extern EstatisticasDespacho estatisticasDespacho;
+
+struct EtapaEstatisticas {
+    static inline bool antes(const ComandoInfo&, Comando&) {
+        estatisticasDespacho.inicio = micros();
+        return true;
+    }
+    static inline void depois(const ComandoInfo&, const Comando&) {
+        unsigned long tempo = micros() - estatisticasDespacho.inicio;
+        estatisticasDespacho.comandos++;
+        estatisticasDespacho.tempoTotal += tempo;
+        if (tempo > estatisticasDespacho.tempoMaximo) estatisticasDespacho.tempoMaximo = tempo;
+    }
+};
+
+// Limite de taxa: recusa comandos recebidos a menos de 'intervalo' milissegundos do anterior.
+template<unsigned long intervalo> struct EtapaLimiteTaxa {
+    static unsigned long ultimoComando;
+    static bool executouComando;
+    static inline bool antes(const ComandoInfo&, Comando&) {
+        unsigned long agora = millis();
+        if (executouComando && agora - ultimoComando < intervalo) {
+            Serial.println("ERRO: Comandos recebidos rápido demais, comando ignorado.");
+            return false;
+        }
+        ultimoComando = agora;
+        executouComando = true;
+        return true;
+    }
+    static inline void depois(const ComandoInfo&, const Comando&) {}
+};
+template<unsigned long intervalo> unsigned long EtapaLimiteTaxa<intervalo>::ultimoComando = 0;
+template<unsigned long intervalo> bool EtapaLimiteTaxa<intervalo>::executouComando = false;
+
+// Permissões: consulta 'comandoPermitido', que deve ser definida pelo sketch ao usar esta etapa
+// (ex: recusar "definir" enquanto a máquina estiver em operação).
+bool comandoPermitido(const ComandoInfo& info, const Comando& comando);
+
+struct EtapaPermissao {
+    static inline bool antes(const ComandoInfo& info, Comando& comando) {
+        if (comandoPermitido(info, comando)) return true;
+        Serial.print("ERRO: Comando não permitido: ");
+        Serial.println(info.nome);
+        return false;
+    }
+    static inline void depois(const ComandoInfo&, const Comando&) {}
+};
+
+#endif
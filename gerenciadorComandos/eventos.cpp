@@ -0,0 +1,137 @@
+/*
+ * eventos.cpp
+ *
+ * Descrição:
+ * Notificações assinadas pelo computador. Veja eventos.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "parametros.h"
+#include "brilho.h" // pinoLigado.
+#include "eventos.h"
+
+enum TipoEvento {
+  EVENTO_FIM_PISCAR,
+  EVENTO_ESTADO_LED,
+  EVENTO_ERRO,
+  EVENTO_PARAMETRO,
+  NUM_TIPOS_EVENTO
+};
+static const char* const nomesEventos[NUM_TIPOS_EVENTO] = {"fimPiscar", "estadoLed", "erro", "parametro"};
+
+static uint8_t assinaturas = 0;        // Um bit por TipoEvento assinado.
+static uint8_t pendentes = 0;          // Um bit por TipoEvento aguardando envio.
+static uint16_t sequenciaEvento = 0;   // Número do próximo evento enviado.
+
+static bool ultimoEstadoLed = false;   // Estado do LED na última amostragem.
+static bool estadoLedEnviado = false;  // Último estado enviado (mudanças que se desfazem antes do envio são descartadas).
+static bool ultimoPiscarAtivo = false;
+static uint16_t parametrosAlterados = 0; // Um bit por parâmetro alterado e ainda não enviado.
+static unsigned int errosPendentes = 0;  // Linhas inválidas desde o último evento "erro".
+
+static bool assinado(uint8_t tipo) {
+  return assinaturas & (1 << tipo);
+}
+
+void notificarParametro(uint8_t indiceParametro) {
+  if (!assinado(EVENTO_PARAMETRO) || indiceParametro >= sizeof(parametrosAlterados) * 8) return;
+  parametrosAlterados |= (uint16_t)1 << indiceParametro; // Alterações repetidas do mesmo parâmetro geram um único evento.
+  pendentes |= 1 << EVENTO_PARAMETRO;
+}
+
+void notificarErro() {
+  if (!assinado(EVENTO_ERRO)) return;
+  if (errosPendentes < 65535U) errosPendentes++;
+  pendentes |= 1 << EVENTO_ERRO;
+}
+
+static void enviarEvento(uint8_t tipo) {
+  Serial.print('!');
+  Serial.print(sequenciaEvento++);
+  Serial.print(' ');
+  Serial.print(nomesEventos[tipo]);
+  if (tipo == EVENTO_ESTADO_LED) {
+    Serial.print(' ');
+    Serial.print(estadoLedEnviado ? 1 : 0);
+  } else if (tipo == EVENTO_ERRO) {
+    Serial.print(' ');
+    Serial.print(errosPendentes);
+    errosPendentes = 0;
+  } else if (tipo == EVENTO_PARAMETRO) {
+    uint8_t indice = 0; // Um parâmetro por linha; os demais ficam para as próximas chamadas.
+    while (!(parametrosAlterados & ((uint16_t)1 << indice))) indice++;
+    parametrosAlterados &= ~((uint16_t)1 << indice);
+    Serial.print(' ');
+    imprimirNomeParametro(Serial, indice);
+    Serial.print('=');
+    Serial.print(lerParametro(indice));
+    if (parametrosAlterados != 0) pendentes |= 1 << EVENTO_PARAMETRO;
+  }
+  Serial.println();
+}
+
+void atualizarEventos() {
+  if (assinaturas == 0) return;
+
+  // Mudanças detectadas por amostragem: valem para qualquer origem (comandos, Modbus ou o loop() do sketch).
+  // Com o brilho controlado, vale o brilho pedido, e não a modulação do pino.
+  bool estadoLed = pinoLigado(ledPin);
+  if (estadoLed != ultimoEstadoLed) {
+    ultimoEstadoLed = estadoLed;
+    if (assinado(EVENTO_ESTADO_LED)) pendentes |= 1 << EVENTO_ESTADO_LED;
+  }
+  if (ultimoPiscarAtivo && !piscarAtivo && assinado(EVENTO_FIM_PISCAR)) pendentes |= 1 << EVENTO_FIM_PISCAR;
+  ultimoPiscarAtivo = piscarAtivo;
+
+  if (pendentes == 0 || Serial.availableForWrite() < GC_ESPACO_EVENTO) return; // Sem espaço: tenta na próxima chamada.
+
+  uint8_t tipo = 0;
+  while (!(pendentes & (1 << tipo))) tipo++;
+  pendentes &= ~(1 << tipo);
+  if (tipo == EVENTO_ESTADO_LED) {
+    if (ultimoEstadoLed == estadoLedEnviado) return; // O LED voltou ao estado já enviado.
+    estadoLedEnviado = ultimoEstadoLed;
+  }
+  enviarEvento(tipo);
+}
+
+// Trata o comando "assinar".
+static void tratarAssinar(Comando comando) {
+  // O comando "assinar" espera o evento e, opcionalmente, 0 ou 1 (padrão 1).
+  if (comando.numValores < 1 || comando.numValores > 2) {
+    Serial.println("Erro: O comando 'assinar' espera 1 ou 2 parâmetros: <evento> [0/1].");
+    return;
+  }
+  uint8_t bits = 0;
+  if (comando.valores[0] == "todos") {
+    bits = (1 << NUM_TIPOS_EVENTO) - 1;
+  } else {
+    for (uint8_t tipo = 0; tipo < NUM_TIPOS_EVENTO; tipo++) {
+      if (comando.valores[0] == nomesEventos[tipo]) bits = 1 << tipo;
+    }
+  }
+  if (bits == 0) {
+    Serial.print("Erro: Evento desconhecido: ");
+    Serial.println(comando.valores[0]);
+    return;
+  }
+  if (comando.numValores == 2 && comando.valores[1].toInt() == 0) {
+    assinaturas &= ~bits;
+    pendentes &= ~bits;
+  } else {
+    if (!(assinaturas & (1 << EVENTO_ESTADO_LED))) { // Estado inicial: apenas as mudanças seguintes são enviadas.
+      ultimoEstadoLed = estadoLedEnviado = pinoLigado(ledPin); // Como em atualizarEventos.
+    }
+    ultimoPiscarAtivo = piscarAtivo;
+    assinaturas |= bits;
+  }
+  Serial.print("Eventos assinados:"); // Confirma a lista completa de assinaturas.
+  for (uint8_t tipo = 0; tipo < NUM_TIPOS_EVENTO; tipo++) {
+    if (!assinado(tipo)) continue;
+    Serial.print(' ');
+    Serial.print(nomesEventos[tipo]);
+  }
+  Serial.println();
+}
+REGISTRAR_COMANDO("assinar", tratarAssinar, "<evento|todos> [0/1]");
@@ -0,0 +1,48 @@
+/*
+ * eventos.h
+ *
+ * Descrição:
+ * Notificações enviadas pela placa sem que o computador precise consultá-la
+ * (em vez de enviar "status" várias vezes por segundo para detectar mudanças).
+ *
+ * Funcionalidade Principal:
+ * O comando "assinar <evento>" ativa o envio de um evento:
+ *   fimPiscar  - o piscar terminou (fim das piscadas ou "desligarLed"/"ligarLed").
+ *   estadoLed  - o LED mudou de estado (valor atual: 0 ou 1).
+ *   erro       - linhas inválidas recebidas (quantidade desde o último aviso).
+ *   parametro  - um parâmetro foi alterado ("definir" ou Modbus), no formato "nome=valor".
+ * Cada evento é uma linha "!<sequência> <evento> [dados]", ex: "!12 estadoLed 1".
+ * O '!' distingue os eventos das respostas aos comandos, e a sequência (0 a 65535)
+ * permite ao computador verificar que nenhum evento foi perdido.
+ *
+ * Os eventos são agrupados: uma mudança repetida antes do envio gera uma única linha,
+ * com o valor mais recente. As linhas são enviadas por 'atualizarEventos', uma por vez e
+ * apenas quando há espaço no buffer de transmissão, sem atrasar o loop().
+ * Com um endereço RS-485 configurado os eventos não são enviados, pois a placa só pode
+ * transmitir quando o mestre do barramento a consulta.
+ *
+ * Exemplo de Comando:
+ * "assinar estadoLed" (passa a enviar "!N estadoLed 0/1" a cada mudança do LED)
+ * "assinar estadoLed 0" (cancela a assinatura)
+ * "assinar todos"
+ */
+
+#ifndef EVENTOS_H
+#define EVENTOS_H
+
+#include <Arduino.h>
+
+// Espaço livre mínimo no buffer de transmissão para enviar um evento sem bloquear.
+#ifndef GC_ESPACO_EVENTO
+#define GC_ESPACO_EVENTO 32
+#endif
+
+// Informam ocorrências que não podem ser detectadas por amostragem.
+void notificarParametro(uint8_t indiceParametro); // Parâmetro alterado.
+void notificarErro();                             // Linha inválida recebida.
+
+// Detecta mudanças (LED e piscar) e envia no máximo um evento pendente.
+// Chamada por gerenciadorComando::atualizar() entre as linhas recebidas.
+void atualizarEventos();
+
+#endif
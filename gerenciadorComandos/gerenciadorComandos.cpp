@@ -18,7 +18,8 @@
  * 1. Inclua "gerenciadorComandos.h" no seu sketch Arduino.
  * 2. Defina as funções de tratamento (handlers) para cada comando.
  * 3. Popule a tabela 'tabelaComandos' no arquivo .cpp com os nomes dos
- *    comandos e os ponteiros para suas respectivas funções de tratamento.
+ *    comandos e os ponteiros para suas respectivas funções de tratamento
+ *    (ou registre-os no próprio módulo com REGISTRAR_COMANDO).
  * 4. Use as funções 'analisarComando' e 'processarComando' para processar
  *    os comandos recebidos pela Serial.
  *
@@ -37,6 +38,13 @@
                     // como pinMode(), digitalWrite(), analogRead(), Serial.begin(), delay(), millis(), etc.
                     // É *obrigatória* em praticamente todos os sketches do Arduino.
 #include "gerenciadorComandos.h" // Inclui o cabeçalho desta biblioteca (gerenciador de comandos).
+#include "parametros.h"          // Registro de parâmetros (comandos "ler", "definir" e "parametros").
+#include "eventos.h"             // Eventos assinados pelo computador (comando "assinar").
+#include "telemetria.h"          // Envio periódico do estado (comando "telemetria").
+#include "amostragem.h"          // Aquisição de sinais em blocos binários (comando "amostrar").
+#include "padrao.h"              // Sequências de liga/desliga (comando "padrao").
+#include "brilho.h"              // Controle de brilho (comandos "brilho" e "fade").
+#include "etapasDespacho.h"      // Etapas executadas antes e depois de cada comando (GC_ETAPAS_DESPACHO).
 
 // Declaração das variáveis globais (definidas aqui, declaradas com 'extern' no .h)
 bool piscarAtivo = false;            // Flag que indica se o modo de piscar está ativo.
@@ -79,6 +87,8 @@ void tratarLigarLed(Comando comando) {
         return; // Saída antecipada da função em caso de erro
     } 
     piscarAtivo = false;     // Desativa o piscar (Esse comando é uma garantia caso o piscarLed esteja ativo).
+    pararPadrao(ledPin);     // Encerra também um padrão em execução no LED (comando "padrao")...
+    pararBrilho(ledPin);     // ...e o controle de brilho (comandos "brilho" e "fade").
     // Se a execução chegou até aqui, significa que `comando.numValores` é igual a 0 (nenhum parâmetro foi fornecido).
     // Define o pino do LED (ledPin) como HIGH, ligando o LED.
     digitalWrite(ledPin, HIGH); // Liga o LED
@@ -88,6 +98,8 @@ void tratarLigarLed(Comando comando) {
 void tratarPiscarLed(Comando comando) {
     // Ativa a flag `piscarAtivo`, indicando que o modo de piscar está em execução.
     piscarAtivo = true;
+    pararPadrao(ledPin); // O piscar substitui um padrão em execução no LED (comando "padrao")...
+    pararBrilho(ledPin); // ...e o controle de brilho (comandos "brilho" e "fade").
 
     // Lógica para tratar diferentes quantidades de parâmetros para o comando "piscarLed".
 
@@ -203,6 +215,8 @@ void tratarDesligarLed(Comando comando) {
     digitalWrite(ledPin, LOW); // Desliga o LED
     // Desativa a flag `piscarAtivo`, interrompendo qualquer ciclo de piscar que estivesse em andamento.
     piscarAtivo = false;     // Desativa o piscar
+    pararPadrao(ledPin);     // Encerra também um padrão em execução no LED (comando "padrao")...
+    pararBrilho(ledPin);     // ...e o controle de brilho (comandos "brilho" e "fade").
 }
 
 // Funções de tratamento dos comandos
@@ -230,75 +244,889 @@ void tratarAjuda(Comando comando) {
   Serial.println("  - <numPiscadas>: Pisca o LED o número especificado de vezes, com 1 segundo ligado e 1 segundo desligado."); // Imprime na Serial a descrição do "piscarLed" com um parâmetro (Número de piscadas).
   Serial.println("  - <tempoLigado> <tempoDesligado>: Pisca indefinidamente com os tempos fornecidos (em milissegundos)."); // Imprime na Serial a descrição do "piscarLed" com dois parâmetros (tempo ligado e tempo desligado).
   Serial.println("  - <numPiscadas> <tempoLigado> <tempoDesligado>: Pisca o LED <numPiscadas> vezes com os tempos fornecidos (em milissegundos)."); // Imprime na Serial a descrição do "piscarLed" com três parâmetros (número de piscadas, tempo ligado e tempo desligado).
+  Serial.println("ler <parametro>: Exibe o valor de um parâmetro."); // Imprime na Serial a descrição do comando "ler".
+  Serial.println("definir <parametro> <valor>: Altera o valor de um parâmetro."); // Imprime na Serial a descrição do comando "definir".
+  Serial.println("parametros: Exibe todos os parâmetros em uma linha."); // Imprime na Serial a descrição do comando "parametros".
+  for (IndiceComando i = 0; i < numComandosRegistrados(); i++) { // Comandos registrados pelos módulos (REGISTRAR_COMANDO), com os seus argumentos.
+    const ComandoInfo* info = comandoRegistrado(i);
+    Serial.print(info->nome);
+    if (info->esquema != nullptr && info->esquema[0] != '\0') {
+      Serial.print(' ');
+      Serial.print(info->esquema);
+    }
+    Serial.println();
+  }
   Serial.println("ajuda: Exibe esta lista de comandos."); // Imprime na Serial a descrição do próprio comando "ajuda".
   Serial.println("------------------"); // Imprime uma linha separadora na Serial para melhorar a legibilidade.
 }
 
+// Imprime "nome=valor" de um parâmetro.
+static void imprimirParametro(uint8_t indice) {
+  imprimirNomeParametro(Serial, indice);
+  Serial.print('=');
+  Serial.print(lerParametro(indice));
+}
+
+// Procura o parâmetro informado no comando, imprimindo um erro se ele não existir.
+static int parametroDoComando(Comando comando) {
+  int indice = buscarParametro(comando.valores[0]); // Busca pelo hash do nome: custo constante.
+  if (indice < 0) {
+    Serial.print("Erro: Parâmetro desconhecido: ");
+    Serial.println(comando.valores[0]);
+  }
+  return indice;
+}
+
+// Trata o comando "ler".
+void tratarLer(Comando comando) {
+  // O comando "ler" espera exatamente um parâmetro: o nome do parâmetro a ser lido.
+  if (comando.numValores != 1) {
+    Serial.println("Erro: O comando 'ler' espera 1 parâmetro: <parametro>.");
+    return;
+  }
+  int indice = parametroDoComando(comando);
+  if (indice < 0) return;
+  imprimirParametro(indice); // Responde no formato "nome=valor".
+  Serial.println();
+}
+
+// Trata o comando "definir".
+void tratarDefinir(Comando comando) {
+  // O comando "definir" espera o nome do parâmetro e o novo valor.
+  if (comando.numValores != 2) {
+    Serial.println("Erro: O comando 'definir' espera 2 parâmetros: <parametro> <valor>.");
+    return;
+  }
+  int indice = parametroDoComando(comando);
+  if (indice < 0) return;
+
+  // Ao contrário de toInt(), strtol permite verificar se o valor inteiro é um número.
+  char* fim;
+  long valor = strtol(comando.valores[1], &fim, 10);
+  if (*fim != '\0' || valor < -32768L || valor > 32767L) {
+    Serial.println("Erro: O valor deve ser um número inteiro.");
+    return;
+  }
 
+  ResultadoParametro resultado = validarParametro(indice, (int)valor); // Verifica a permissão e a faixa descritas na tabela.
+  if (resultado == PARAMETRO_SOMENTE_LEITURA) {
+    Serial.println("Erro: Este parâmetro é somente leitura.");
+    return;
+  }
+  if (resultado == PARAMETRO_FORA_DA_FAIXA) {
+    ParametroInfo parametro = descricaoParametro(indice);
+    Serial.print("Erro: O valor deve estar entre ");
+    Serial.print(parametro.minimo);
+    Serial.print(" e ");
+    Serial.print(parametro.maximo);
+    Serial.println(".");
+    return;
+  }
+  alterarParametro(indice, (int)valor); // Também grava a alteração no diário da EEPROM e gera o evento "parametro".
+  imprimirParametro(indice); // Confirma o novo valor no formato "nome=valor".
+  Serial.println();
+}
+
+// Trata o comando "parametros".
+void tratarParametros(Comando comando) {
+  // O comando "parametros" não espera nenhum parâmetro.
+  if (comando.numValores != 0) {
+    Serial.println("Erro: O comando 'parametros' não espera nenhum parâmetro.");
+    return;
+  }
+  // Todos os parâmetros em uma única linha ("nome=valor nome=valor ..."),
+  // para que um programa no computador leia a configuração inteira em uma só resposta.
+  for (uint8_t i = 0; i < numParametros(); i++) {
+    if (i > 0) Serial.print(' ');
+    imprimirParametro(i);
+  }
+  Serial.println();
+}
+
+// Lista dos comandos da tabela principal: nome, função de tratamento, argumentos (exibidos pela "ajuda")
+// e orçamento de tempo em milissegundos (0 = GC_ORCAMENTO_PADRAO).
+// A mesma lista gera a tabela de despacho (tabelaComandos) e, com GC_DESPACHO_ESTATICO, o switch de executarLinha().
+#define GC_LISTA_COMANDOS(X) \
+  X("status", tratarStatus, "", 0)                 /* Quando o usuário digitar "status", o programa vai chamar a função tratarStatus. */ \
+  X("ligarLed", tratarLigarLed, "", 0)             /* Se o usuário digitar "ligarLed", a função tratarLigarLed será executada, acendendo o LED (a luzinha). */ \
+  X("piscarLed", tratarPiscarLed, "[numPiscadas] [tempoLigado tempoDesligado]", 0) /* Ao digitar "piscarLed", a função tratarPiscarLed entra em ação, fazendo o LED piscar. */ \
+  X("desligarLed", tratarDesligarLed, "", 0)       /* Com "desligarLed", a função tratarDesligarLed é chamada, apagando o LED. */ \
+  X("ler", tratarLer, "<parametro>", 0)            /* "ler tempoLigado" exibe o valor de um parâmetro do registro (parametros.cpp). */ \
+  X("definir", tratarDefinir, "<parametro> <valor>", 0) /* "definir tempoLigado 250" altera um parâmetro, respeitando a faixa da tabela. */ \
+  X("parametros", tratarParametros, "", 0)         /* "parametros" exibe todos os parâmetros de uma vez. */ \
+  X("ajuda", tratarAjuda, "", 1500)                /* Se o usuário precisar de ajuda e digitar "ajuda", a função tratarAjuda mostrará uma lista com todos os comandos disponíveis. */
+
+#define GC_ENTRADA_TABELA(nome, funcao, esquema, orcamento) {nome, funcao, esquema, orcamento},
 ComandoInfo gerenciadorComando::tabelaComandos[] = { // Cria uma tabela chamada tabelaComandos dentro da classe gerenciadorComando. 
                                                      // Essa tabela serve como um "guia" para o programa, associando os nomes dos comandos que 
                                                      // o usuário pode digitar com as funções que devem ser executadas para cada comando. 
                                                      // É como um índice de um livro: o nome do comando é o título e a função é o conteúdo da página.
-  {"status", tratarStatus}, // Quando o usuário digitar "status", o programa vai chamar a função tratarStatus.
-  {"ligarLed", tratarLigarLed}, // Se o usuário digitar "ligarLed", a função tratarLigarLed será executada, acendendo o LED (a luzinha).
-  {"piscarLed", tratarPiscarLed}, // Ao digitar "piscarLed", a função tratarPiscarLed entra em ação, fazendo o LED piscar.
-  {"desligarLed", tratarDesligarLed}, // Com "desligarLed", a função tratarDesligarLed é chamada, apagando o LED.
-  {"ajuda", tratarAjuda}, // Se o usuário precisar de ajuda e digitar "ajuda", a função tratarAjuda mostrará uma lista com todos os comandos disponíveis e uma breve explicação de cada um. É como um manual de instruções dentro do programa.
-  {nullptr, nullptr} // Essa linha é muito importante! Ela marca o final da tabela. 
+  GC_LISTA_COMANDOS(GC_ENTRADA_TABELA) // Uma linha {nome, funcao, esquema, orcamento} para cada comando da lista acima.
+  {nullptr, nullptr, nullptr, 0} // Essa linha é muito importante! Ela marca o final da tabela. 
                      // É como colocar um ponto final em uma frase. O programa usa essa marcação para saber onde a tabela termina. 
                      // Sem ela, o programa pode tentar ler dados errados na memória, causando erros. 
                      // nullptr significa "ponteiro nulo", ou seja, não aponta para lugar nenhum, indicando o fim da lista.
 };
 
-Comando gerenciadorComando::analisarComando(String comandoRecebido) {
-  /*
-   * Objetivo: Esta função analisa uma string de comando recebida, separando o nome do comando e seus valores numéricos.
-   * Parâmetro: comandoRecebido - A string contendo o comando e seus valores. Ex: "piscarLed 10 200 300"
-   * Retorno: Um struct Comando contendo o nome do comando e um array de até o maximo de valores numéricos (representados como strings, para posterior conversão).
-   */
+// A tabela principal precisa caber inteira no índice; os comandos registrados pelos módulos são verificados em construirIndice().
+#define GC_CONTAR_COMANDO(nome, funcao, esquema, orcamento) + 1
+static_assert(0 GC_LISTA_COMANDOS(GC_CONTAR_COMANDO) <= GC_MAX_COMANDOS, "A tabela de comandos não cabe em GC_MAX_COMANDOS");
+
+#if GC_DESPACHO_ESTATICO
+// Identificador de cada comando da tabela principal (a sua posição em tabelaComandos).
+#define GC_ID_COMANDO(nome, funcao, esquema, orcamento) ID_##funcao,
+enum IdComando { GC_LISTA_COMANDOS(GC_ID_COMANDO) NUM_COMANDOS_TABELA };
+
+// Executa o comando de posição 'id' com um switch: cada caso chama a função de tratamento
+// diretamente, e o compilador pode expandi-la no próprio caso (sem a chamada indireta por ponteiro).
+#define GC_CASO_DESPACHO(nome, funcao, esquema, orcamento) case ID_##funcao: funcao(comando); break;
+static inline void despacharTabela(uint8_t id, Comando comando) {
+  switch (id) {
+    GC_LISTA_COMANDOS(GC_CASO_DESPACHO)
+  }
+}
+#endif
+
+#if GC_CHECKSUM == GC_CHECKSUM_CRC8
+// Tabela do CRC-8 (polinômio 0x07), guardada na memória flash (PROGMEM) para não ocupar RAM.
+// Com ela, cada byte recebido custa uma leitura da tabela e um XOR.
+static const uint8_t tabelaCrc8[256] PROGMEM = {
+  0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+  0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+  0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+  0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+  0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+  0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+  0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+  0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+  0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+  0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+  0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+  0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+  0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+  0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+  0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+  0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+#endif
+
+gerenciadorComando::gerenciadorComando() {
+  numComandos = 0; // O índice ordenado é construído na primeira utilização (construirIndice).
+#if GC_BUSCA == GC_BUSCA_LINEAR
+  memset(histogramaAcertos, 0, sizeof(histogramaAcertos));
+#endif
+  indiceConstruido = false;
+  estado = AGUARDANDO_NOME; // Começa aguardando o início de uma linha.
+  faixaInicio = 0;
+  faixaFim = 0;
+  posicaoNome = 0;
+  comandoReconhecido = nullptr;
+  ultimoByte = 0;
+  bytesLinha = 0;
+  transbordamentos = 0;
+  naoImprimiveis = 0;
+  errosSeguidos = 0;
+  ressincronizando = false;
+  linhasInvalidas = 0;
+  ultimoResumo = 0;
+  endereco = 0;             // Sem endereço: todas as linhas são aceitas (ligação ponto a ponto).
+  grupo = 0;
+  enderecoRecebido = 0;
+  digitosEndereco = 0;
+  respostaHabilitada = true;
+  pinoDirecao = -1;         // Sem controle de direção (Serial comum ou RS-232).
+  numRotas = 0;             // Sem rotas: a placa não atua como gateway.
+  rotaAtual = 0;
+  rotaAguardada = SEM_ROTA;
+  rotaResposta = SEM_ROTA;
+  ultimaAtividadeRota = 0;
+  difusaoEncaminhada = false;
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+  checksumCalculado = 0;
+  checksumRecebido = 0;
+  digitosChecksum = 0;
+  lendoChecksum = false;
+#endif
+}
+
+uint16_t hashNome(const char* nome) {
+  uint32_t hash = 2166136261UL; // Mesmo cálculo de hashNomeConstante, em laço.
+  while (*nome) {
+    hash = (hash ^ (uint8_t)*nome++) * 16777619UL;
+  }
+  return reduzirHash(hash);
+}
+
+uint16_t hashNome(const char* nome, uint8_t comprimento) {
+  uint32_t hash = 2166136261UL;
+  while (comprimento-- > 0) {
+    hash = (hash ^ (uint8_t)*nome++) * 16777619UL;
+  }
+  return reduzirHash(hash);
+}
+
+#if GC_REGISTRO_SECAO
+// Limites da seção "gc_comandos", definidos pelo linker. 'weak': sem comandos registrados a seção não existe.
+extern "C" const ComandoInfo __start_gc_comandos[] __attribute__((weak));
+extern "C" const ComandoInfo __stop_gc_comandos[] __attribute__((weak));
+
+IndiceComando numComandosRegistrados() {
+  return __stop_gc_comandos - __start_gc_comandos;
+}
+
+const ComandoInfo* comandoRegistrado(IndiceComando i) {
+  return &__start_gc_comandos[i];
+}
+#else
+static const RegistroComando* primeiroRegistro = nullptr; // Lista montada pelos construtores estáticos, antes do setup().
+static IndiceComando totalRegistros = 0;
+
+RegistroComando::RegistroComando(const char* nome, void (*funcao)(Comando), const char* esquema, uint16_t orcamento)
+    : info{nome, funcao, esquema, orcamento}, proximo(primeiroRegistro) {
+  primeiroRegistro = this;
+  totalRegistros++;
+}
+
+IndiceComando numComandosRegistrados() {
+  return totalRegistros;
+}
+
+const ComandoInfo* comandoRegistrado(IndiceComando i) {
+  const RegistroComando* registro = primeiroRegistro;
+  while (i-- > 0) registro = registro->proximo;
+  return &registro->info;
+}
+#endif
+
+void gerenciadorComando::inserirNoIndice(const ComandoInfo* info) {
+  if (numComandos >= GC_MAX_COMANDOS) { // Só acontece com comandos registrados pelos módulos (REGISTRAR_COMANDO).
+    Serial.print("Erro: Índice de comandos cheio (aumente GC_MAX_COMANDOS). Comando ignorado: ");
+    Serial.println(info->nome);
+    return;
+  }
+  IndiceComando j = numComandos; // Posição de inserção, deslocando para a direita os nomes maiores.
+  while (j > 0 && strcmp(nomeOrdenado(j - 1), info->nome) > 0) {
+    comandosOrdenados[j] = comandosOrdenados[j - 1];
+    j--;
+  }
+  comandosOrdenados[j] = info;
+  numComandos++;
+}
+
+void gerenciadorComando::construirIndice() {
+  // Ordena (por inserção) os comandos pelo nome: primeiro os da tabela principal, depois os registrados pelos módulos.
+  // Executado uma única vez: as tabelas são fixas, então o índice nunca precisa ser refeito.
+  numComandos = 0;
+  for (int i = 0; tabelaComandos[i].nome != nullptr; i++) {
+    inserirNoIndice(&tabelaComandos[i]);
+  }
+  for (IndiceComando i = 0; i < numComandosRegistrados(); i++) {
+    inserirNoIndice(comandoRegistrado(i)); // Nome repetido: vale o da tabela principal (a inserção é estável).
+  }
+#if GC_BYTES_CHAVE > 0
+  for (IndiceComando i = 0; i < numComandos; i++) { // Chaves na ordem final do índice.
+    chaves[i].comprimento = strlen(nomeOrdenado(i));
+    strncpy(chaves[i].inicio, nomeOrdenado(i), GC_BYTES_CHAVE); // Nomes curtos são completados com '\0'.
+#if GC_BUSCA == GC_BUSCA_HASH
+    chaves[i].hash = hashNome(nomeOrdenado(i));
+#endif
+  }
+#endif
+#if GC_BUSCA == GC_BUSCA_LINEAR && GC_ORDEM_ADAPTATIVA
+  for (IndiceComando i = 0; i < numComandos; i++) { // Sem uso observado, começa na ordem do índice.
+    ordemBusca[i] = i;
+    contagemUso[i] = 0;
+  }
+#endif
+#if GC_BUSCA == GC_BUSCA_INICIAL
+  numBaldes = 0; // No índice ordenado, os nomes com a mesma primeira letra já são contíguos.
+  for (IndiceComando i = 0; i < numComandos; i++) {
+    if (numBaldes == 0 || letraBalde[numBaldes - 1] != caractereOrdenado(i, 0)) {
+      letraBalde[numBaldes] = caractereOrdenado(i, 0);
+      inicioBalde[numBaldes++] = i;
+    }
+  }
+  inicioBalde[numBaldes] = numComandos;
+#elif GC_BUSCA == GC_BUSCA_HASH
+  memset(posicaoHash, 0xFF, sizeof(posicaoHash)); // Todos os bytes em 0xFF: POSICAO_VAZIA em qualquer dos tipos.
+  for (IndiceComando i = 0; i < numComandos; i++) {
+    IndiceComando posicao = hashNome(nomeOrdenado(i)) % GC_POSICOES_HASH_COMANDOS;
+    while (posicaoHash[posicao] != POSICAO_VAZIA) posicao = (posicao + 1) % GC_POSICOES_HASH_COMANDOS; // Colisão: próxima posição livre.
+    posicaoHash[posicao] = i;
+  }
+#endif
+  indiceConstruido = true;
+}
+
+#if GC_BUSCA != GC_BUSCA_PREFIXO
+int gerenciadorComando::compararComando(IndiceComando i, const char* nome, uint8_t comprimento) {
+  // Compara o nome do comando 'i' com o nome recebido (que não termina em '\0'), na ordem do índice.
+  for (uint8_t posicao = 0; posicao < comprimento; posicao++) {
+    char c = caractereOrdenado(i, posicao);
+    if (c != nome[posicao]) return (int)(uint8_t)c - (uint8_t)nome[posicao]; // Nome da tabela mais curto: '\0' é menor.
+  }
+  return caractereOrdenado(i, comprimento) != '\0' ? 1 : 0; // Mesmo prefixo: o nome da tabela é maior se continuar.
+}
+
+bool gerenciadorComando::nomeIgual(IndiceComando i, const char* nome, uint8_t comprimento) {
+#if GC_BYTES_CHAVE > 0
+  if (chaves[i].comprimento != comprimento) return false; // Rejeitado pela chave, sem ler o nome completo.
+#endif
+  return compararComando(i, nome, comprimento) == 0;
+}
+
+#if GC_BUSCA == GC_BUSCA_LINEAR
+void gerenciadorComando::registrarAcerto(IndiceComando posicao) {
+  uint8_t faixa = posicao < GC_POSICOES_HISTOGRAMA ? posicao : GC_POSICOES_HISTOGRAMA - 1;
+  if (histogramaAcertos[faixa] < 0xFFFF) histogramaAcertos[faixa]++;
+#if GC_ORDEM_ADAPTATIVA
+  if (contagemUso[posicao] == 0xFF) { // Decaimento: o uso antigo perde peso para o recente.
+    for (IndiceComando i = 0; i < numComandos; i++) contagemUso[i] >>= 1;
+  }
+  contagemUso[posicao]++;
+  // Passa à frente dos comandos com contagem menor (no máximo algumas trocas, pois a ordem já está quase certa).
+  while (posicao > 0 && contagemUso[posicao] > contagemUso[posicao - 1]) {
+    IndiceComando comando = ordemBusca[posicao];
+    uint8_t contagem = contagemUso[posicao];
+    ordemBusca[posicao] = ordemBusca[posicao - 1];
+    contagemUso[posicao] = contagemUso[posicao - 1];
+    ordemBusca[posicao - 1] = comando;
+    contagemUso[posicao - 1] = contagem;
+    posicao--;
+  }
+#endif
+}
+#endif
+
+const ComandoInfo* gerenciadorComando::buscarComando(const char* nome, uint8_t comprimento) {
+#if GC_BUSCA == GC_BUSCA_LINEAR
+  for (IndiceComando posicao = 0; posicao < numComandos; posicao++) {
+#if GC_ORDEM_ADAPTATIVA
+    IndiceComando i = ordemBusca[posicao]; // Comandos mais usados primeiro.
+#else
+    IndiceComando i = posicao;
+#endif
+    if (nomeIgual(i, nome, comprimento)) {
+      registrarAcerto(posicao);
+      return comandosOrdenados[i];
+    }
+  }
+#elif GC_BUSCA == GC_BUSCA_BINARIA
+  IndiceComando inicio = 0;
+  IndiceComando fim = numComandos;
+  while (inicio < fim) {
+    IndiceComando meio = (inicio + fim) / 2;
+    int diferenca = compararComando(meio, nome, comprimento);
+    if (diferenca == 0) return comandosOrdenados[meio];
+    if (diferenca < 0) inicio = meio + 1;
+    else fim = meio;
+  }
+#elif GC_BUSCA == GC_BUSCA_INICIAL
+  for (uint8_t b = 0; b < numBaldes && letraBalde[b] <= nome[0]; b++) {
+    if (letraBalde[b] != nome[0]) continue;
+    for (IndiceComando i = inicioBalde[b]; i < inicioBalde[b + 1]; i++) { // Apenas os nomes com a mesma primeira letra.
+      if (nomeIgual(i, nome, comprimento)) return comandosOrdenados[i];
+    }
+    break;
+  }
+#elif GC_BUSCA == GC_BUSCA_HASH
+  uint16_t hash = hashNome(nome, comprimento);
+  IndiceComando posicao = hash % GC_POSICOES_HASH_COMANDOS;
+  while (posicaoHash[posicao] != POSICAO_VAZIA) { // Uma posição vazia encerra a sequência de colisões.
+    IndiceComando i = posicaoHash[posicao];
+#if GC_BYTES_CHAVE > 0
+    if (chaves[i].hash == hash && nomeIgual(i, nome, comprimento)) return comandosOrdenados[i]; // Colisões descartadas pelo hash da chave.
+#else
+    if (nomeIgual(i, nome, comprimento)) return comandosOrdenados[i];
+#endif
+    posicao = (posicao + 1) % GC_POSICOES_HASH_COMANDOS;
+  }
+#endif
+  return nullptr;
+}
+#endif
+
+void gerenciadorComando::avancarNome(char c) {
+  // Restringe a faixa de candidatos aos nomes cujo caractere na posição 'posicaoNome' é 'c'.
+  // Como o índice é ordenado e todos os candidatos compartilham o prefixo já recebido,
+  // os nomes que continuam compatíveis formam uma faixa contígua dentro da faixa atual.
+  IndiceComando inicio = faixaInicio;
+  while (inicio < faixaFim && (uint8_t)caractereOrdenado(inicio, posicaoNome) < (uint8_t)c) {
+    inicio++; // Pula os nomes com caractere menor (inclui nomes que já terminaram, pois '\0' < c).
+  }
+  IndiceComando fim = inicio;
+  while (fim < faixaFim && caractereOrdenado(fim, posicaoNome) == c) {
+    fim++; // Avança sobre os nomes que continuam compatíveis.
+  }
+  faixaInicio = inicio;
+  faixaFim = fim; // Se a faixa ficar vazia o nome já está rejeitado; os próximos bytes não custam nada.
+  posicaoNome++;
+}
+
+void gerenciadorComando::concluirNome() {
+#if GC_BUSCA != GC_BUSCA_PREFIXO
+  // O nome recebido está no início do buffer da linha (ainda sem o '\0'): busca conforme GC_BUSCA.
+  comandoReconhecido = posicaoNome > 0 ? buscarComando(linha.texto + linha.inicioToken[0], posicaoNome) : nullptr;
+  estado = comandoReconhecido != nullptr ? LENDO_ARGUMENTOS : NOME_INVALIDO;
+#else
+  // O nome terminou. Entre os candidatos restantes, o único que pode ter exatamente
+  // 'posicaoNome' caracteres é o primeiro da faixa (o nome mais curto vem antes na ordenação).
+  if (faixaInicio < faixaFim && caractereOrdenado(faixaInicio, posicaoNome) == '\0') {
+    comandoReconhecido = comandosOrdenados[faixaInicio]; // Comando identificado antes de receber os argumentos.
+    estado = LENDO_ARGUMENTOS;
+  } else {
+    comandoReconhecido = nullptr;
+    estado = NOME_INVALIDO; // Nome desconhecido: os argumentos serão ignorados.
+  }
+#endif
+}
+
+void gerenciadorComando::receberByte(char c) {
+  ultimoByte = millis(); // Registra o instante do byte para o tempo limite de linha sem '\n'.
+
+  if (c == '\r') return; // Ignora o '\r' enviado pelo Monitor Serial na opção "Ambos, NL e CR".
+  if (c == '\n') {       // Fim da linha: executa o comando.
+    concluirLinha();
+    return;
+  }
+
+  if (estado == ENCAMINHANDO) {      // Linha de outra placa atrás deste gateway:
+    rotas[rotaAtual].porta->write(c); // o byte vai do buffer de recepção direto para o de transmissão da rota.
+    return;
+  }
+  if (difusaoEncaminhada) {          // Difusão: executada aqui e repassada, byte a byte, às rotas.
+    for (uint8_t i = 0; i < numRotas; i++) rotas[i].porta->write(c);
+  }
+
+  if (estado == DESCARTANDO || estado == IGNORANDO) return; // Ignora tudo até o '\n', sem guardar nada.
+
+  if (estado == AGUARDANDO_NOME) {
+    if (c == ' ' || c == '\t') return; // Ignora espaços antes do nome.
+    if (c != '@' && endereco != 0) {  // Barramento endereçado: linha sem endereço não é para esta placa
+      estado = IGNORANDO;             // (pode ser, por exemplo, a resposta de outra placa).
+      return;
+    }
+    if (!indiceConstruido) construirIndice();
+    bytesLinha = 0;
+    naoImprimiveis = 0;
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+    checksumCalculado = 0;   // O checksum começa no primeiro caractere não-espaço da linha.
+    digitosChecksum = 0;
+    lendoChecksum = false;
+#endif
+    faixaInicio = 0;         // Todos os comandos são candidatos no início do nome.
+    faixaFim = numComandos;
+    posicaoNome = 0;
+    linha.limpar();          // A linha anterior só é descartada quando a próxima começa.
+    enderecoRecebido = 0;
+    digitosEndereco = 0;
+    difusaoEncaminhada = false;
+    respostaHabilitada = true; // Sem prefixo (ou endereço individual): a placa pode responder.
+    estado = (c == '@') ? LENDO_ENDERECO : LENDO_NOME; // O primeiro caractere é tratado logo abaixo.
+  }
 
-  Comando comando; // Cria uma variável chamada comando do tipo struct Comando. Essa variável armazenará as informações do comando que será analisado.
-  comando.nome = ""; // Limpa o nome do comando, colocando uma string vazia. Isso evita que restos de comandos anteriores causem erros.
-  comando.numValores = 0; // Zera o contador de valores. Assim como o nome, isso evita que valores antigos interfiram na análise do novo comando.
-  for (int i = 0; i < Comando::maxValores; i++) { // Este loop percorre o array de valores dentro do struct Comando.
-    comando.valores[i] = ""; // Inicializa cada posição do array de valores com uma string vazia. Importante para evitar "lixo" na memória.
+  if (bytesLinha >= GC_TAMANHO_LINHA) { // Limite da linha atingido: descarta a linha inteira.
+    estado = DESCARTANDO;               // Um comando truncado nunca é executado.
+    transbordamentos++;
+    return;
   }
-  comandoRecebido.trim(); // Remove espaços em branco extras no início e no final da string recebida. Por exemplo: "   piscarLed 10 " se torna "piscarLed 10".
+  bytesLinha++;
+  if ((uint8_t)c < ' ' || (uint8_t)c >= 0x7F) naoImprimiveis++; // Indício de ruído ou de taxa de transmissão errada.
 
-  if (comandoRecebido.length() == 0) return comando; // Se a string estiver vazia (só espaços ou nada), retorna o comando vazio. Isso evita erros ao tentar processar uma string sem conteúdo.
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+  if (lendoChecksum) {         // Bytes após o '*' são o checksum, não fazem parte do comando.
+    receberDigitoChecksum(c);
+    return;
+  }
+  if (c == '*') {              // Início do checksum: encerra o nome (se ainda estiver sendo lido) e os argumentos.
+    if (estado == LENDO_NOME) concluirNome();
+    lendoChecksum = true;
+    return;
+  }
+#if GC_CHECKSUM == GC_CHECKSUM_CRC8
+  checksumCalculado = pgm_read_byte(&tabelaCrc8[checksumCalculado ^ (uint8_t)c]); // Atualiza o CRC com o byte recebido.
+#else
+  checksumCalculado ^= (uint8_t)c; // Atualiza o XOR com o byte recebido.
+#endif
+#endif
 
-  int pos = comandoRecebido.indexOf(' '); // Procura o primeiro espaço em branco na string. Este espaço separa o nome do comando dos seus valores.
-                                          // Se não houver espaço, pos será -1.
+  if (estado == LENDO_ENDERECO) {
+    receberCaractereEndereco(c); // O endereço é verificado antes de guardar qualquer byte da linha.
+    return;
+  }
 
-  if (pos != -1) { // Verifica se encontrou um espaço. Se sim, significa que o comando tem pelo menos um valor.
+  if (estado == LENDO_NOME) {
+    if (c == ' ' || c == '\t') {
+      if (posicaoNome == 0) return; // Espaços entre o endereço e o nome.
+      concluirNome(); // O primeiro espaço encerra o nome: o comando já fica conhecido aqui.
+    } else {
+#if GC_BUSCA == GC_BUSCA_PREFIXO
+      if (faixaInicio < faixaFim) avancarNome(c);
+#else
+      posicaoNome++; // As demais buscas acontecem uma única vez, ao fim do nome.
+#endif
+    }
+    linha.adicionar(c); // O nome é guardado mesmo se inválido, para a mensagem de erro.
+  } else if (estado == LENDO_ARGUMENTOS) {
+    linha.adicionar(c); // Guarda o caractere e registra os limites do token no mesmo passo.
+  }
+  // Em NOME_INVALIDO a linha já foi rejeitada: os argumentos nem são guardados.
+}
+
+void gerenciadorComando::definirEndereco(uint8_t enderecoPlaca, uint8_t grupoPlaca) {
+  endereco = enderecoPlaca;
+  grupo = grupoPlaca;
+  permitirEnvioAmostras(endereco == 0); // Com endereço, os blocos de "amostrar" não podem ser enviados.
+}
 
-    comando.nome = comandoRecebido.substring(0, pos); // Extrai o nome do comando. É a parte da string que vem antes do primeiro espaço.
-                                                      // Ex: Se comandoRecebido é "piscarLed 10", comando.nome será "piscarLed".
-    comandoRecebido = comandoRecebido.substring(pos + 1); // Remove o nome do comando e o espaço da string original, deixando apenas os valores.
-                                                          // Ex: Se antes era "piscarLed 10 200", agora será "10 200".
-    comandoRecebido.trim(); // Remove espaços extras entre os valores, como múltiplos espaços entre "10" e "200".
+void gerenciadorComando::definirPinoDirecao(int pino) {
+  pinoDirecao = pino;
+  if (pinoDirecao >= 0) {
+    pinMode(pinoDirecao, OUTPUT);
+    digitalWrite(pinoDirecao, LOW); // Transmissor desabilitado: a placa apenas escuta o barramento.
+  }
+}
 
-    int i = 0; // Cria um contador para controlar quantos valores foram lidos.
-    while (i < Comando::maxValores && comandoRecebido.length() > 0) { // Loop que lê os valores. Ele continua enquanto não atingir o limite máximo de valores (Comando::maxValores) e enquanto ainda houver texto na string comandoRecebido.
-                                                                    // O limite maximo de valores protege contra erros de acessar posições inválidas na memória (estouro de buffer) em comando.valores.
-      pos = comandoRecebido.indexOf(' '); // Procura o próximo espaço em branco.
+void gerenciadorComando::receberCaractereEndereco(char c) {
+  if (c == '@' && bytesLinha == 1) return; // O '@' que inicia a linha.
+  if (c >= '0' && c <= '9' && digitosEndereco < 3) {
+    enderecoRecebido = enderecoRecebido * 10 + (c - '0');
+    digitosEndereco++;
+    return;
+  }
+  if ((c == ' ' || c == '\t') && digitosEndereco > 0 && enderecoRecebido <= 255) {
+    // Endereço completo: decide aqui se a linha é para esta placa, antes de guardar o comando.
+    if (endereco != 0 && enderecoRecebido == endereco) {
+      estado = LENDO_NOME;        // Endereço individual desta placa.
+      return;
+    }
+    if (enderecoRecebido != GC_ENDERECO_DIFUSAO) {
+      for (uint8_t i = 0; i < numRotas; i++) { // As rotas antes da placa sem endereço: um gateway não precisa de endereço próprio.
+        if (enderecoRecebido >= rotas[i].enderecoInicial && enderecoRecebido <= rotas[i].enderecoFinal) {
+          rotaAtual = i;          // Placa atrás deste gateway: a linha é repassada sem ser analisada.
+          rotas[i].ultimoDestino = enderecoRecebido;
+          escreverEndereco(*rotas[i].porta, c);
+          estado = ENCAMINHANDO;
+          return;
+        }
+      }
+    }
+    if (endereco == 0) {
+      estado = LENDO_NOME;        // Placa sem endereço configurado: aceita os demais endereços.
+    } else if (enderecoRecebido == GC_ENDERECO_DIFUSAO || (grupo != 0 && enderecoRecebido == grupo)) {
+      estado = LENDO_NOME;        // Difusão ou grupo: o comando é executado, mas sem resposta,
+      respostaHabilitada = false; // para que várias placas não transmitam ao mesmo tempo.
+      if (enderecoRecebido == GC_ENDERECO_DIFUSAO && numRotas > 0) {
+        for (uint8_t i = 0; i < numRotas; i++) escreverEndereco(*rotas[i].porta, c);
+        difusaoEncaminhada = true; // O restante da linha também será repassado às rotas.
+      }
+    } else {
+      estado = IGNORANDO;         // Outra placa: o resto da linha é pulado sem custo.
+    }
+    return;
+  }
+  estado = IGNORANDO; // Endereço mal formado: a linha não é tratada por nenhuma placa.
+}
+
+bool gerenciadorComando::adicionarRota(uint8_t enderecoInicial, uint8_t enderecoFinal, Stream& porta) {
+  if (numRotas >= GC_MAX_ROTAS) return false; // Tabela de rotas cheia.
+  Rota& rota = rotas[numRotas++];
+  rota.enderecoInicial = enderecoInicial;
+  rota.enderecoFinal = enderecoFinal;
+  rota.porta = &porta;
+  rota.ultimoDestino = enderecoInicial;
+  return true;
+}
+
+void gerenciadorComando::escreverEndereco(Stream& porta, char separador) {
+  // O prefixo já foi consumido durante a análise do endereço; é reescrito com o mesmo número de
+  // dígitos (zeros à esquerda incluídos), para que um checksum da linha continue válido no destino.
+  char prefixo[4];
+  unsigned int valor = enderecoRecebido;
+  prefixo[0] = '@';
+  for (uint8_t i = digitosEndereco; i > 0; i--) {
+    prefixo[i] = '0' + valor % 10;
+    valor /= 10;
+  }
+  porta.write((const uint8_t*)prefixo, digitosEndereco + 1);
+  porta.write(separador);
+}
 
-      if (pos != -1) { // Se encontrou um espaço, significa que ainda há mais valores a serem lidos.
-        comando.valores[i] = comandoRecebido.substring(0, pos); // Extrai o valor atual (até o próximo espaço).
-        comandoRecebido = comandoRecebido.substring(pos + 1); // Remove o valor lido e o espaço da string.
-        comandoRecebido.trim(); // Remove espaços extras após o valor lido.
-      } else { // Se não encontrou espaço, significa que este é o último valor.
-        comando.valores[i] = comandoRecebido; // Extrai o último valor restante.
-        comandoRecebido = ""; // Limpa a string comandoRecebido para encerrar o loop.
+void gerenciadorComando::repassarRespostas() {
+  for (uint8_t i = 0; i < numRotas; i++) {
+    if (rotaResposta != SEM_ROTA && rotaResposta != i) continue; // Linha de outra rota em andamento: esta espera.
+    Rota& rota = rotas[i];
+    while (rota.porta->available() > 0) { // Cada byte recebido da rota é devolvido imediatamente à Serial.
+      char c = (char)rota.porta->read();
+      ultimaAtividadeRota = millis();
+      if (rotaResposta == SEM_ROTA) {     // Início de uma linha de resposta: identifica a origem e reserva a Serial.
+        iniciarTransmissao(true);         // No RS-485 o transmissor fica habilitado até o fim da linha.
+        Serial.write('#');
+        Serial.print(rota.ultimoDestino);
+        Serial.write(' ');
+        rotaResposta = i;
+      }
+      Serial.write(c);
+      if (c == '\n') {
+        encerrarTransmissao(true);
+        rotaResposta = SEM_ROTA;          // A Serial fica livre para as outras rotas e para a própria placa.
+        break;
       }
-      i++; // Incrementa o contador de valores lidos.
     }
-    comando.numValores = i; // Armazena a quantidade total de valores numéricos que foram lidos.
-  } else { // Se não encontrou nenhum espaço na string original, significa que o comando não tem valores.
+  }
+  if ((rotaResposta != SEM_ROTA || rotaAguardada != SEM_ROTA) && millis() - ultimaAtividadeRota >= GC_TEMPO_RESPOSTA_ROTA) {
+    if (rotaResposta != SEM_ROTA) {       // Resposta interrompida sem '\n': o gateway encerra a linha e libera o barramento.
+      Serial.println();
+      encerrarTransmissao(true);
+      rotaResposta = SEM_ROTA;
+    }
+    rotaAguardada = SEM_ROTA;             // Rota em silêncio: a próxima linha pode ser lida.
+  }
+}
 
-    comando.nome = comandoRecebido; // O nome do comando é a string inteira. Ex: "piscarLed".
+void gerenciadorComando::iniciarTransmissao(bool permitida) {
+  if (pinoDirecao >= 0 && permitida) {
+    digitalWrite(pinoDirecao, HIGH); // Habilita o transmissor RS-485 antes da resposta.
   }
-  return comando; // Retorna o struct Comando preenchido com o nome do comando e seus valores.
+}
+
+void gerenciadorComando::encerrarTransmissao(bool permitida) {
+  if (pinoDirecao < 0) return;
+  Serial.flush();                   // Aguarda o último byte sair da UART. Sem resposta permitida, o transmissor
+                                    // está desligado: o que a função escreveu não chega ao barramento e não
+                                    // fica no buffer para sair junto com a próxima resposta.
+  if (permitida) digitalWrite(pinoDirecao, LOW); // Só então libera o barramento.
+}
+
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+void gerenciadorComando::receberDigitoChecksum(char c) {
+  uint8_t valor;
+  if (c >= '0' && c <= '9') valor = c - '0';
+  else if (c >= 'A' && c <= 'F') valor = c - 'A' + 10;
+  else if (c >= 'a' && c <= 'f') valor = c - 'a' + 10;
+  else if ((c == ' ' || c == '\t') && digitosChecksum == 2) return; // Espaços após o checksum são tolerados.
+  else {
+    digitosChecksum = 0xFF; // Caractere inesperado: checksum mal formado.
+    return;
+  }
+  if (digitosChecksum >= 2) { // Mais de dois dígitos (ou formato já inválido).
+    digitosChecksum = 0xFF;
+    return;
+  }
+  checksumRecebido = (checksumRecebido << 4) | valor;
+  digitosChecksum++;
+}
+
+bool gerenciadorComando::checksumValido() {
+  if (!lendoChecksum) return !GC_CHECKSUM_OBRIGATORIO; // Linha sem '*': aceita, a menos que o checksum seja obrigatório.
+  return digitosChecksum == 2 && checksumRecebido == checksumCalculado;
+}
+#endif
+
+bool gerenciadorComando::registrarLinhaInvalida() {
+  notificarErro();
+  if (errosSeguidos < 255) errosSeguidos++;
+  if (errosSeguidos >= GC_ERROS_PARA_RESSINCRONIZAR) {
+    ressincronizando = true; // Muitos erros seguidos: provavelmente lixo, e não um usuário digitando errado.
+  }
+  if (ressincronizando) {
+    if (linhasInvalidas < 65535U) linhasInvalidas++; // Apenas conta; o resumo é enviado por atualizar().
+    return false;
+  }
+  return respostaHabilitada; // Erro isolado: a mensagem detalhada continua sendo enviada (exceto em difusão e grupo).
+}
+
+void gerenciadorComando::registrarLinhaValida() {
+  errosSeguidos = 0;
+  ressincronizando = false; // O resumo pendente (se houver) ainda será enviado por atualizar().
+}
+
+void gerenciadorComando::concluirLinha() {
+  if (estado == AGUARDANDO_NOME) return; // Linha vazia (ou só espaços): nada a executar.
+  if (estado == IGNORANDO || estado == LENDO_ENDERECO) { // Linha de outra placa (ou só com o endereço): silenciosamente ignorada.
+    estado = AGUARDANDO_NOME;
+    return;
+  }
+  if (estado == ENCAMINHANDO) {            // Fim de uma linha encaminhada: apenas repassa o terminador.
+    rotas[rotaAtual].porta->write('\n');
+    rotaAguardada = rotaAtual;             // As próximas linhas esperam a resposta desta.
+    ultimaAtividadeRota = millis();
+    estado = AGUARDANDO_NOME;
+    return;
+  }
+  if (difusaoEncaminhada) {                // Fim de uma difusão repassada às rotas.
+    for (uint8_t i = 0; i < numRotas; i++) rotas[i].porta->write('\n');
+    difusaoEncaminhada = false;
+  }
+
+  // Com RS-485, o transmissor fica habilitado apenas durante a resposta (mensagens de erro ou do comando).
+  iniciarTransmissao(respostaHabilitada);
+  executarLinha();
+  encerrarTransmissao(respostaHabilitada);
+}
+
+void gerenciadorComando::executarLinha() {
+  if (estado == DESCARTANDO) {          // Fim de uma linha longa demais: apenas informa o descarte.
+    estado = AGUARDANDO_NOME;
+    if (registrarLinhaInvalida()) {
+      Serial.print("ERRO: Linha maior que ");
+      Serial.print(GC_TAMANHO_LINHA);
+      Serial.println(" caracteres descartada.");
+    }
+    return;
+  }
+  if (estado == LENDO_NOME) concluirNome(); // Linha sem argumentos: o nome termina junto com a linha.
+
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+  if (!checksumValido()) { // Linha corrompida (ou sem o checksum obrigatório): rejeitada antes de montar o comando.
+    estado = AGUARDANDO_NOME;
+    if (registrarLinhaInvalida()) {
+      Serial.println(lendoChecksum ? "ERRO: Checksum inválido, linha descartada." : "ERRO: Checksum ausente, linha descartada.");
+    }
+    return;
+  }
+#endif
+
+  Comando comando = linha.montarComando(); // Os tokens já estão delimitados: nenhuma nova varredura da linha.
+  estado = AGUARDANDO_NOME; // Prepara para a próxima linha antes de executar o comando.
+
+  if (comandoReconhecido == nullptr) {
+    if (registrarLinhaInvalida()) {
+      Serial.print("ERRO: Comando inválido: "); // Mesma mensagem de processarComando.
+      Serial.println(comando.nome);
+      Serial.println("Digite 'ajuda' para listar os comandos disponíveis.");
+    }
+    return;
+  }
+  if ((unsigned int)naoImprimiveis * 100 > (unsigned int)bytesLinha * GC_PERCENTUAL_NAO_IMPRIMIVEIS) {
+    // Nome válido, mas o restante da linha parece lixo: não executa um comando possivelmente corrompido.
+    if (registrarLinhaInvalida()) {
+      Serial.println("ERRO: Linha com caracteres inválidos descartada.");
+    }
+    return;
+  }
+
+  registrarLinhaValida();
+  typedef EtapasDespacho<GC_ETAPAS_DESPACHO> Etapas; // Padrão: EtapaOrcamento. Lista vazia: nenhuma instrução a mais.
+  const ComandoInfo& info = *comandoReconhecido;
+  if (!Etapas::antes(info, comando)) return; // Comando recusado por uma das etapas.
+#if GC_DESPACHO_ESTATICO
+  // Comandos da tabela principal: switch com as funções expandidas no local. Comandos registrados: ponteiro.
+  uintptr_t posicao = ((uintptr_t)&info - (uintptr_t)tabelaComandos) / sizeof(ComandoInfo); // Fora da tabela: valor muito grande.
+  if (posicao < NUM_COMANDOS_TABELA) {
+    despacharTabela(posicao, comando);
+  } else {
+    info.funcao(comando);
+  }
+#else
+  info.funcao(comando); // Executa diretamente, sem procurar o nome na tabela novamente.
+#endif
+  Etapas::depois(info, comando);
+}
+
+void gerenciadorComando::atualizar() {
+  if (numRotas > 0) repassarRespostas(); // Gateway: devolve as respostas das placas das rotas.
+  while (Serial.available() > 0) { // Entrega ao reconhecedor todos os bytes já recebidos pela Serial.
+    // Gateway: nada é lido durante uma resposta repassada (a resposta desta placa seria intercalada), e uma
+    // nova linha só é lida depois da resposta da linha encaminhada (os bytes aguardam no buffer da Serial).
+    if (!serialLivre() || (estado == AGUARDANDO_NOME && rotaAguardada != SEM_ROTA)) break;
+    receberByte((char)Serial.read());
+  }
+  // Linha sem '\n' (Monitor Serial em "Nenhum final de linha"): conclui após o tempo limite.
+  if (estado != AGUARDANDO_NOME && serialLivre() && millis() - ultimoByte >= GC_TEMPO_LIMITE_LINHA) {
+    concluirLinha();
+  }
+  // Resumo das linhas descartadas durante a ressincronização, no máximo um a cada GC_INTERVALO_RESUMO_ERROS.
+  // Assim o ruído recebido nunca gera mais tráfego de saída do que uma linha por intervalo.
+  // Como os eventos, apenas sem endereço RS-485: no barramento a placa só transmite quando consultada.
+  if (linhasInvalidas > 0 && endereco == 0 && serialLivre() && millis() - ultimoResumo >= GC_INTERVALO_RESUMO_ERROS) {
+    iniciarTransmissao(true);
+    Serial.print(linhasInvalidas);
+    Serial.println(" linhas inválidas descartadas");
+    encerrarTransmissao(true);
+    linhasInvalidas = 0;
+    ultimoResumo = millis();
+  }
+  // Eventos assinados: enviados apenas entre as linhas recebidas (nunca no meio de uma resposta)
+  // e apenas sem endereço RS-485, pois no barramento a placa só transmite quando consultada.
+  // Também não são enviados no meio de uma resposta repassada de uma rota.
+  bool podeEnviar = endereco == 0 && estado == AGUARDANDO_NOME && serialLivre();
+  if (podeEnviar) atualizarEventos();
+  atualizarTelemetria(podeEnviar); // Mede todas as execuções; envia nas mesmas condições dos eventos.
+  atualizarAmostragem(podeEnviar); // Coleta sempre; envia nas mesmas condições dos eventos.
+}
+
+void LinhaTokenizada::limpar() {
+  comprimento = 0; // Esvazia o buffer e descarta os tokens da linha anterior.
+  numTokens = 0;
+  dentroToken = false;
+}
+
+void LinhaTokenizada::encerrarToken() {
+  fimToken[numTokens - 1] = comprimento; // Registra onde o token termina.
+  texto[comprimento++] = '\0';           // Termina o token, para que possa ser usado como string C.
+  dentroToken = false;
+}
+
+void LinhaTokenizada::adicionar(char c) {
+  if (c == ' ' || c == '\t' || c == '\r' || c == '\n') { // Espaço: apenas encerra o token atual.
+    if (dentroToken) encerrarToken();                   // Espaços repetidos não ocupam o buffer.
+    return;
+  }
+  if (!dentroToken) { // Primeiro caractere de um novo token.
+    // Tokens além do limite (nome + maxValores) são ignorados, como na análise original.
+    if (numTokens >= maxTokens || comprimento >= GC_TAMANHO_LINHA) return;
+    inicioToken[numTokens++] = comprimento; // Registra onde o token começa.
+    dentroToken = true;
+  }
+  // Sempre sobra espaço para o '\0' do token: caracteres além de GC_TAMANHO_LINHA são descartados.
+  if (comprimento < GC_TAMANHO_LINHA) texto[comprimento++] = c;
+}
+
+Comando LinhaTokenizada::montarComando() {
+  static const char vazio[] = ""; // Texto dos tokens ausentes (evita ponteiros nulos nos handlers).
+
+  if (dentroToken) encerrarToken(); // O último token termina junto com a linha.
+
+  Comando comando;
+  comando.nome.texto = vazio;
+  comando.nome.comprimento = 0;
+  for (int i = 0; i < Comando::maxValores; i++) { // Inicializa os valores ausentes com texto vazio.
+    comando.valores[i].texto = vazio;
+    comando.valores[i].comprimento = 0;
+  }
+  comando.numValores = 0;
+
+  for (uint8_t i = 0; i < numTokens; i++) { // Apenas converte os deslocamentos registrados na recepção em tokens.
+    Token token;
+    token.texto = texto + inicioToken[i];
+    token.comprimento = fimToken[i] - inicioToken[i];
+    if (i == 0) {
+      comando.nome = token;        // O primeiro token é o nome do comando.
+    } else {
+      comando.valores[i - 1] = token; // Os demais são os valores (argumentos).
+    }
+  }
+  if (numTokens > 1) comando.numValores = numTokens - 1;
+  return comando;
+}
+
+Comando gerenciadorComando::analisarComando(String comandoRecebido) {
+  /*
+   * Objetivo: Esta função analisa uma string de comando recebida, separando o nome do comando e seus valores numéricos.
+   * Parâmetro: comandoRecebido - A string contendo o comando e seus valores. Ex: "piscarLed 10 200 300"
+   * Retorno: Um struct Comando contendo o nome do comando e um array de até o maximo de valores numéricos (representados como strings, para posterior conversão).
+   *
+   * A recepção pela Serial (receberByte) não usa esta função: lá os tokens são registrados enquanto os bytes chegam.
+   * Os tokens retornados apontam para um buffer interno, válido até a próxima chamada de analisarComando.
+   */
+
+  static LinhaTokenizada linhaAnalisada; // 'static' dentro da função: só ocupa memória se analisarComando for usada.
+  linhaAnalisada.limpar();
+  for (unsigned int i = 0; i < comandoRecebido.length(); i++) { // Mesmo tokenizador da recepção byte a byte.
+    linhaAnalisada.adicionar(comandoRecebido[i]);
+  }
+  return linhaAnalisada.montarComando();
 }
 
 void gerenciadorComando::processarComando(Comando comando) {
@@ -318,6 +1146,13 @@ void gerenciadorComando::processarComando(Comando comando) {
 
       return; // Após executar a função do comando, a função 'processarComando' termina. Isso evita que o loop continue procurando, o que seria desnecessário.
     }
+  }
+  for (IndiceComando i = 0; i < numComandosRegistrados(); i++) { // Depois da tabela, os comandos registrados pelos módulos (REGISTRAR_COMANDO).
+    const ComandoInfo* info = comandoRegistrado(i);
+    if (comando.nome == info->nome) {
+      info->funcao(comando);
+      return;
+    }
   }
     // Se o loop terminar sem encontrar o comando:
   Serial.print("ERRO: Comando inválido: "); // Imprime uma mensagem indicando que o comando é inválido.
@@ -18,7 +18,8 @@
  * 1. Inclua "gerenciadorComandos.h" no seu sketch Arduino.
  * 2. Defina as funções de tratamento (handlers) para cada comando.
  * 3. Popule a tabela 'tabelaComandos' no arquivo .cpp com os nomes dos
- *    comandos e os ponteiros para suas respectivas funções de tratamento.
+ *    comandos e os ponteiros para suas respectivas funções de tratamento
+ *    (ou registre-os no próprio módulo com REGISTRAR_COMANDO).
  * 4. Use as funções 'analisarComando' e 'processarComando' para processar
  *    os comandos recebidos pela Serial.
  *
@@ -36,22 +37,167 @@
 #ifndef GERENCIADOR_COMANDOS_H
 #define GERENCIADOR_COMANDOS_H
       
+// Tamanho máximo (em bytes) de uma linha recebida, contando espaços e sem contar o '\n'.
+// Uma linha maior é descartada inteira (até o próximo '\n'), sem ocupar memória adicional:
+// o consumo de RAM da recepção é fixo, mesmo com lixo contínuo chegando pela Serial.
+// Os espaços entre os tokens não são guardados, apenas um '\0' ao final de cada token.
+#ifndef GC_TAMANHO_LINHA
+#define GC_TAMANHO_LINHA 64
+#endif
+#if GC_TAMANHO_LINHA > 254
+#error "GC_TAMANHO_LINHA deve ser no máximo 254 (os deslocamentos dos tokens são guardados em uint8_t)."
+#endif
+
+// Referência a um trecho (token) da linha recebida, sem cópia.
+// O texto aponta para dentro do buffer da linha e termina com '\0', então pode ser
+// impresso diretamente (Serial.println(token)) e convertido com toInt(), como uma String.
+struct Token {
+    const char* texto;   // Início do token dentro do buffer da linha. Ex: "ligarLed".
+    uint8_t comprimento; // Número de caracteres do token.
+
+    long toInt() const { return atol(texto); } // Converte o token para inteiro (mesmo comportamento de String::toInt()).
+    bool operator==(const char* outro) const { return strcmp(texto, outro) == 0; } // Compara o conteúdo, não o ponteiro.
+    operator const char*() const { return texto; } // Permite usar o token onde uma string C é esperada.
+
+    // Consultas com os mesmos nomes e resultados dos métodos de String, para que as funções de
+    // tratamento escritas para String continuem funcionando. O token é somente leitura: para
+    // alterá-lo (concat, toUpperCase, replace, ...), copie-o antes com String(token.c_str()).
+    unsigned int length() const { return comprimento; }
+    const char* c_str() const { return texto; }
+    char charAt(unsigned int i) const { return i < comprimento ? texto[i] : '\0'; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    float toFloat() const { return atof(texto); }
+    bool operator==(const String& outro) const { return equals(outro.c_str()); }
+    bool operator!=(const char* outro) const { return !equals(outro); }
+    bool equals(const char* outro) const { return strcmp(texto, outro) == 0; }
+    bool equals(const String& outro) const { return equals(outro.c_str()); }
+    bool equalsIgnoreCase(const char* outro) const { return strcasecmp(texto, outro) == 0; }
+    bool equalsIgnoreCase(const String& outro) const { return equalsIgnoreCase(outro.c_str()); }
+    bool startsWith(const char* prefixo) const { return strncmp(texto, prefixo, strlen(prefixo)) == 0; }
+    bool endsWith(const char* sufixo) const {
+        unsigned int n = strlen(sufixo);
+        return n <= comprimento && strcmp(texto + comprimento - n, sufixo) == 0;
+    }
+    int indexOf(char c, unsigned int inicio = 0) const {
+        if (inicio >= comprimento) return -1;
+        const char* p = strchr(texto + inicio, c);
+        return p ? p - texto : -1;
+    }
+    int indexOf(const char* trecho, unsigned int inicio = 0) const {
+        if (inicio > comprimento) return -1;
+        const char* p = strstr(texto + inicio, trecho);
+        return p ? p - texto : -1;
+    }
+    String substring(unsigned int inicio) const { return String(texto).substring(inicio); }
+    String substring(unsigned int inicio, unsigned int fim) const { return String(texto).substring(inicio, fim); }
+};
+
 // Estrutura para armazenar as informações de um comando individual.
+// Os tokens apontam para o buffer em que a linha foi recebida: são válidos durante a
+// execução da função de tratamento, até a chegada da próxima linha.
 struct Comando {
-    String nome;                    // Nome do comando. Ex: "ligarLed".
+    Token nome;                     // Nome do comando. Ex: "ligarLed".
     static const int maxValores = 5; // Número máximo de valores que um comando pode ter. 
                                      // O limite maximo de valores protege contra erros de acessar posições inválidas na memória (estouro de buffer) em comando.valores.
-    String valores[maxValores];     // Array para armazenar até o limite maximo (maxValores) de valores (argumentos) do comando.
+    Token valores[maxValores];      // Array para armazenar até o limite maximo (maxValores) de valores (argumentos) do comando.
     int numValores;                // Número de valores presentes no comando.
 };
 
+// Linha recebida, já dividida em tokens.
+// Os caracteres são guardados em um buffer fixo à medida que chegam, e o início e o fim
+// de cada token são registrados no mesmo passo (espaços repetidos são descartados na hora).
+// Ao fim da linha, o comando é montado a partir dos deslocamentos, sem percorrer a linha de novo.
+struct LinhaTokenizada {
+    static const uint8_t maxTokens = Comando::maxValores + 1; // Nome + valores.
+
+    char texto[GC_TAMANHO_LINHA + 1];  // Tokens separados por '\0'. Ex: "piscarLed\03\0500\0".
+    uint8_t comprimento;               // Bytes ocupados em 'texto'.
+    uint8_t inicioToken[maxTokens];    // Deslocamento do primeiro caractere de cada token.
+    uint8_t fimToken[maxTokens];       // Deslocamento do '\0' que encerra cada token.
+    uint8_t numTokens;                 // Tokens iniciados até agora.
+    bool dentroToken;                  // Se o último caractere recebido pertence a um token.
+
+    void limpar();                     // Prepara para uma nova linha.
+    void adicionar(char c);            // Acrescenta um caractere (espaços apenas encerram o token atual).
+    void encerrarToken();              // Fecha o token atual com '\0' e registra seu fim.
+    Comando montarComando();           // Monta o Comando a partir dos tokens registrados.
+};
+
+// Hash dos nomes de comandos e parâmetros (FNV-1a de 32 bits, reduzido a 16 bits).
+// A versão 'constexpr' é calculada pelo compilador, para tabelas guardadas na memória flash;
+// hashNome() dá o mesmo resultado em tempo de execução, para os nomes recebidos pela Serial.
+constexpr uint32_t hashNomeFnv(const char* nome, uint32_t hash) {
+    return *nome ? hashNomeFnv(nome + 1, (hash ^ (uint8_t)*nome) * 16777619UL) : hash;
+}
+constexpr uint16_t reduzirHash(uint32_t hash) { return (uint16_t)(hash ^ (hash >> 16)); }
+constexpr uint16_t hashNomeConstante(const char* nome) { return reduzirHash(hashNomeFnv(nome, 2166136261UL)); }
+uint16_t hashNome(const char* nome);
+uint16_t hashNome(const char* nome, uint8_t comprimento); // Para nomes sem '\0' (ex: ainda no buffer de recepção).
+
 // Estrutura para a tabela de comandos.
 // Associa um nome de comando (string C) a um ponteiro para uma função que trata esse comando.
 struct ComandoInfo {
     const char* nome;        // Nome do comando (string C). Ex: "ligarLed".
     void (*funcao)(Comando); // Ponteiro para a função que processa o comando.
+    const char* esquema;     // Argumentos esperados, exibidos pela "ajuda" (nullptr = não informado). Ex: "[n] [ligado] [desligado]".
+    uint16_t orcamento;      // Tempo máximo de execução da função, em milissegundos (0 = GC_ORCAMENTO_PADRAO).
 };
 
+// Tempo máximo de execução (em milissegundos) dos comandos sem orçamento próprio.
+// Comandos que excedem o orçamento são informados pela etapa EtapaOrcamento (etapasDespacho.h).
+// Lembre que as respostas longas também contam: a 9600 bauds, cada 100 caracteres levam cerca de 100ms
+// quando o buffer de transmissão está cheio.
+#ifndef GC_ORCAMENTO_PADRAO
+#define GC_ORCAMENTO_PADRAO 100
+#endif
+
+// Registro de comandos fora da tabela principal: cada módulo declara os seus comandos
+// no próprio arquivo .cpp, sem alterar 'tabelaComandos':
+//
+//     REGISTRAR_COMANDO("salvar", tratarSalvar, "");
+//     REGISTRAR_COMANDO("salvar", tratarSalvar, "", 250); // Com orçamento de tempo próprio (ms).
+//
+// Os comandos registrados entram no mesmo índice ordenado da tabela principal na primeira
+// linha recebida, então o reconhecimento byte a byte continua igual para todos os comandos.
+// Com GC_REGISTRO_SECAO igual a 1 (padrão nas placas de 32 bits), as entradas são reunidas
+// pelo linker na seção "gc_comandos", sem nenhum custo na inicialização.
+// Nas placas AVR, em que o linker não mantém seções novas, cada entrada é encadeada
+// em uma lista por um construtor estático (2 bytes de RAM por comando).
+#ifndef GC_REGISTRO_SECAO
+#if defined(__ELF__) && !defined(__AVR__) && !defined(ESP8266)
+#define GC_REGISTRO_SECAO 1
+#else
+#define GC_REGISTRO_SECAO 0
+#endif
+#endif
+
+// Monta um ComandoInfo na compilação (o orçamento de tempo é opcional).
+constexpr ComandoInfo criarComandoInfo(const char* nome, void (*funcao)(Comando), const char* esquema, uint16_t orcamento = 0) {
+    return ComandoInfo{nome, funcao, esquema, orcamento};
+}
+
+#if GC_REGISTRO_SECAO
+// O alinhamento explícito impede o compilador de alinhar (e espaçar) as entradas além do tamanho de ComandoInfo.
+#define REGISTRAR_COMANDO(nome, funcao, ...) \
+    __attribute__((section("gc_comandos"), used, aligned(__alignof__(ComandoInfo)))) \
+    static const ComandoInfo gcComando_##funcao = criarComandoInfo(nome, funcao, __VA_ARGS__)
+#else
+struct RegistroComando {
+    ComandoInfo info;
+    const RegistroComando* proximo; // Próximo comando registrado (nullptr = último).
+    RegistroComando(const char* nome, void (*funcao)(Comando), const char* esquema, uint16_t orcamento = 0);
+};
+#define REGISTRAR_COMANDO(nome, funcao, ...) \
+    static const RegistroComando gcComando_##funcao(nome, funcao, __VA_ARGS__)
+#endif
+
+// Despacho dos comandos da tabela principal por um switch gerado na compilação (GC_LISTA_COMANDOS),
+// em vez da chamada indireta pelo ponteiro de ComandoInfo: as funções de tratamento podem ser
+// expandidas no próprio caso do switch. Mude para 0 para usar sempre o ponteiro da tabela.
+#ifndef GC_DESPACHO_ESTATICO
+#define GC_DESPACHO_ESTATICO 1
+#endif
+
 // Declaração das variáveis globais que controlam o piscar do LED.
 // O uso de 'extern' indica que a definição real dessas variáveis está em outro arquivo (.cpp).
 extern bool piscarAtivo;            // Indica se o modo de piscar está ativo.
@@ -62,19 +208,323 @@ extern int tempoLigadoAtual;        // Tempo atual em que o LED deve permanecer
 extern int tempoDesligadoAtual;     // Tempo atual em que o LED deve permanecer desligado (em milissegundos).
 extern const int ledPin;            // Declaração do pino do LED (definido no .ino).
 
+// Número máximo de comandos na tabela de despacho.
+// Limita o tamanho do índice ordenado usado pelo reconhecimento de nomes byte a byte.
+#ifndef GC_MAX_COMANDOS
+#define GC_MAX_COMANDOS 32
+#endif
+
+// Forma de busca do nome do comando no índice ordenado. Cada placa pode escolher a que
+// melhor equilibra tempo de busca, RAM e memória flash para o seu número de comandos:
+#define GC_BUSCA_PREFIXO 0 // Reconhecimento byte a byte (padrão): a faixa de candidatos é reduzida a cada caractere recebido.
+#define GC_BUSCA_LINEAR  1 // Comparação com cada nome ao fim do nome recebido. Menor código; adequada para poucos comandos.
+#define GC_BUSCA_BINARIA 2 // Busca binária no índice ordenado ao fim do nome. Sem RAM adicional.
+#define GC_BUSCA_INICIAL 3 // Baldes por primeira letra (2 bytes de RAM por letra inicial diferente) e comparação dentro do balde.
+#define GC_BUSCA_HASH    4 // Índice de hash (hashNome) com GC_POSICOES_HASH_COMANDOS posições de RAM. Custo constante.
+#ifndef GC_BUSCA
+#define GC_BUSCA GC_BUSCA_PREFIXO
+#endif
+// Ordem adaptativa da busca linear (GC_BUSCA_LINEAR): os comandos são percorridos na ordem
+// de uso observada, e não na ordem alfabética. Cada acerto soma 1 à contagem do comando, que
+// passa à frente dos comandos menos usados; quando uma contagem chega a 255, todas são divididas
+// por 2, para que a ordem acompanhe mudanças no tráfego. Custa 2 bytes de RAM por comando.
+#ifndef GC_ORDEM_ADAPTATIVA
+#define GC_ORDEM_ADAPTATIVA 0
+#endif
+// Número de posições do histograma de acertos da busca linear (a última acumula as posições seguintes).
+#ifndef GC_POSICOES_HISTOGRAMA
+#define GC_POSICOES_HISTOGRAMA 8
+#endif
+
+// Número de posições do índice de hash dos comandos. Deve ser maior que GC_MAX_COMANDOS: sobra
+// sempre uma posição vazia, que encerra a busca.
+#ifndef GC_POSICOES_HASH_COMANDOS
+#define GC_POSICOES_HASH_COMANDOS (2 * GC_MAX_COMANDOS)
+#endif
+#if GC_BUSCA == GC_BUSCA_HASH
+static_assert(GC_POSICOES_HASH_COMANDOS > GC_MAX_COMANDOS && GC_POSICOES_HASH_COMANDOS <= 65535,
+              "GC_POSICOES_HASH_COMANDOS deve ser maior que GC_MAX_COMANDOS e no máximo 65535");
+#endif
+
+// Tipo das posições do índice de comandos. Até 254 comandos (e 255 posições de hash) basta
+// um byte por posição; acima disso o índice passa a usar 2 bytes por posição. O maior valor
+// do tipo marca as posições vazias do índice de hash.
+#if GC_MAX_COMANDOS > 254 || (GC_BUSCA == GC_BUSCA_HASH && GC_POSICOES_HASH_COMANDOS > 255)
+typedef uint16_t IndiceComando;
+#else
+typedef uint8_t IndiceComando;
+#endif
+static_assert(GC_MAX_COMANDOS < 65535, "GC_MAX_COMANDOS deve ser menor que 65535");
+
+// Acesso aos comandos registrados com REGISTRAR_COMANDO (na ordem do linker ou da inicialização).
+IndiceComando numComandosRegistrados();
+const ComandoInfo* comandoRegistrado(IndiceComando i);
+
+// Chaves "quentes" do índice de comandos: para cada comando, o comprimento e os primeiros
+// GC_BYTES_CHAVE caracteres do nome (e o hash, com GC_BUSCA_HASH) ficam em um vetor compacto,
+// separado de ComandoInfo (nome completo, esquema e função, consultados apenas após a busca).
+// A busca compara primeiro as chaves, que ocupam poucas linhas de cache contíguas, e só lê o
+// nome completo para os caracteres além da chave. Nas placas AVR (sem cache, nomes na RAM)
+// o padrão é 0, que desativa as chaves e economiza a RAM correspondente.
+#ifndef GC_BYTES_CHAVE
+#if defined(__AVR__)
+#define GC_BYTES_CHAVE 0
+#else
+#define GC_BYTES_CHAVE 5
+#endif
+#endif
+
+#if GC_BYTES_CHAVE > 0
+struct ChaveComando {
+#if GC_BUSCA == GC_BUSCA_HASH
+    uint16_t hash;                 // hashNome do nome completo.
+#endif
+    uint8_t comprimento;           // Comprimento do nome.
+    char inicio[GC_BYTES_CHAVE];   // Primeiros caracteres do nome (completados com '\0').
+};
+#endif
+
+// Tempo (em milissegundos) sem receber bytes após o qual uma linha sem '\n' é considerada completa.
+// Mantém o comportamento do antigo Serial.readStringUntil('\n') (timeout padrão de 1000ms)
+// quando o Monitor Serial está configurado como "Nenhum final de linha".
+#ifndef GC_TEMPO_LIMITE_LINHA
+#define GC_TEMPO_LIMITE_LINHA 1000
+#endif
+
+// Proteção contra lixo na Serial (ex: taxa de transmissão errada ou ruído na linha).
+// Após GC_ERROS_PARA_RESSINCRONIZAR linhas inválidas seguidas, o gerenciador entra em
+// ressincronização: as mensagens de erro de cada linha deixam de ser enviadas e as linhas
+// descartadas passam a ser apenas contadas, gerando no máximo um resumo
+// ("N linhas inválidas descartadas") a cada GC_INTERVALO_RESUMO_ERROS milissegundos.
+// A primeira linha válida encerra a ressincronização.
+#ifndef GC_ERROS_PARA_RESSINCRONIZAR
+#define GC_ERROS_PARA_RESSINCRONIZAR 3
+#endif
+#ifndef GC_INTERVALO_RESUMO_ERROS
+#define GC_INTERVALO_RESUMO_ERROS 5000
+#endif
+// Porcentagem máxima de caracteres não imprimíveis em uma linha; acima disso a linha é tratada como lixo.
+#ifndef GC_PERCENTUAL_NAO_IMPRIMIVEIS
+#define GC_PERCENTUAL_NAO_IMPRIMIVEIS 25
+#endif
+
+// Verificação de integridade opcional por linha, no estilo NMEA: "piscarLed 3 500 250*5A".
+// O valor após o '*' (dois dígitos hexadecimais) cobre todos os bytes desde o primeiro caractere
+// não-espaço da linha até o byte anterior ao '*'. É calculado byte a byte durante a recepção,
+// e uma linha corrompida é rejeitada antes de virar comando.
+// Linhas sem '*' continuam aceitas, a menos que GC_CHECKSUM_OBRIGATORIO seja 1.
+#define GC_CHECKSUM_NENHUM 0 // Sem verificação (o '*' é tratado como um caractere comum).
+#define GC_CHECKSUM_XOR    1 // XOR de todos os bytes (compatível com NMEA 0183).
+#define GC_CHECKSUM_CRC8   2 // CRC-8 (polinômio 0x07), com tabela de 256 bytes na memória flash.
+#ifndef GC_CHECKSUM
+#define GC_CHECKSUM GC_CHECKSUM_XOR
+#endif
+#ifndef GC_CHECKSUM_OBRIGATORIO
+#define GC_CHECKSUM_OBRIGATORIO 0
+#endif
+
+// Endereçamento para barramentos multiponto (RS-485): "@12 piscarLed 3".
+// Com um endereço configurado (definirEndereco), a placa só trata linhas com o seu endereço,
+// com o endereço do seu grupo ou com o endereço de difusão. As demais linhas (inclusive as sem '@')
+// são puladas byte a byte até o '\n', sem serem guardadas nem analisadas.
+// Comandos de difusão e de grupo são executados sem resposta, para evitar colisões no barramento.
+#ifndef GC_ENDERECO_DIFUSAO
+#define GC_ENDERECO_DIFUSAO 0
+#endif
+
+// Roteamento (placa como gateway): linhas "@N ..." cujo endereço N pertence a uma rota são
+// repassadas byte a byte, sem análise e sem cópia, para a porta da rota (ex: Serial1).
+// As rotas são consultadas antes do endereço da placa: um gateway não precisa de endereço próprio
+// (sem endereço, as linhas de endereços fora das rotas são executadas pelo próprio gateway).
+// As respostas recebidas nessa porta voltam pela Serial precedidas de "#N ", onde N é o
+// último endereço encaminhado para ela. O '#' não é confundido com um endereço ('@') pelas
+// outras placas do barramento. Linhas de difusão também são repassadas a todas as rotas.
+// Uma linha é encaminhada por vez: a próxima linha recebida só é lida depois que a rota ficar
+// GC_TEMPO_RESPOSTA_ROTA ms em silêncio, para que cada resposta receba o endereço correto.
+// Enquanto uma linha de resposta é repassada, a Serial fica reservada para ela (nenhuma outra
+// saída é intercalada); uma linha sem '\n' é encerrada pelo gateway após o mesmo tempo.
+#ifndef GC_MAX_ROTAS
+#define GC_MAX_ROTAS 2
+#endif
+#ifndef GC_TEMPO_RESPOSTA_ROTA
+#define GC_TEMPO_RESPOSTA_ROTA 100
+#endif
+
+// Rota de encaminhamento para uma faixa de endereços.
+struct Rota {
+    uint8_t enderecoInicial; // Primeiro endereço atendido pela rota.
+    uint8_t enderecoFinal;   // Último endereço atendido pela rota.
+    Stream* porta;           // Porta em que estão as placas da rota.
+    uint8_t ultimoDestino;   // Último endereço encaminhado (identifica a origem das respostas).
+};
+
 // Classe gerenciadorComando.
 // Encapsula a lógica para analisar e processar comandos.
 class gerenciadorComando {
 public:
+    gerenciadorComando();
+
     // Analisa uma string de comando recebida, extraindo o nome do comando e seus valores.
     Comando analisarComando(String comandoRecebido);
 
     // Processa um comando, buscando-o na tabela de comandos e executando a função correspondente.
     void processarComando(Comando comando);
 
+    // Lê todos os bytes disponíveis na Serial e os entrega a receberByte().
+    // Também conclui linhas que ficaram sem '\n' por mais de GC_TEMPO_LIMITE_LINHA.
+    // Deve ser chamada a cada execução do loop().
+    void atualizar();
+
+    // Entrega um byte recebido ao reconhecedor de comandos.
+    // O nome do comando é reconhecido enquanto os bytes chegam: ao receber o primeiro espaço
+    // o comando já está identificado, e nomes inválidos são rejeitados antes do fim da linha.
+    void receberByte(char c);
+
+    // Configura o endereço da placa no barramento (1 a 255) e, opcionalmente, um endereço de grupo.
+    // Endereço 0 (padrão) desativa o endereçamento: todas as linhas são aceitas.
+    void definirEndereco(uint8_t enderecoPlaca, uint8_t grupoPlaca = 0);
+
+    // Configura o pino de controle de direção (DE/RE) de um transceptor RS-485 half-duplex.
+    // O pino fica em HIGH apenas enquanto a resposta de um comando é transmitida. -1 desativa.
+    void definirPinoDirecao(int pino);
+
+    // Encaminha para 'porta' as linhas endereçadas de 'enderecoInicial' a 'enderecoFinal'.
+    // Retorna false se a tabela de rotas (GC_MAX_ROTAS) estiver cheia.
+    bool adicionarRota(uint8_t enderecoInicial, uint8_t enderecoFinal, Stream& porta);
+
+    // Número de linhas descartadas por excederem GC_TAMANHO_LINHA desde a inicialização.
+    unsigned int linhasTransbordadas() const { return transbordamentos; }
+
+    // Indica se o gerenciador está ressincronizando após uma sequência de linhas inválidas.
+    bool emRessincronizacao() const { return ressincronizando; }
+
+    // Indica se a linha em execução pode ser respondida (falso para difusão e grupo).
+    // As mensagens de erro do gerenciador já são suprimidas; funções de tratamento que escrevem
+    // na Serial devem consultar antes de responder. Com o pino DE configurado, o que for escrito
+    // mesmo assim é descartado (sai da UART com o transmissor desligado).
+    bool respostaPermitida() const { return respostaHabilitada; }
+
+#if GC_BUSCA == GC_BUSCA_LINEAR
+    // Histograma da busca linear: quantos comandos foram encontrados na comparação 'posicao' (0 = primeira).
+    // A última posição (GC_POSICOES_HISTOGRAMA - 1) acumula também as posições seguintes.
+    uint16_t acertosNaPosicao(uint8_t posicao) const { return posicao < GC_POSICOES_HISTOGRAMA ? histogramaAcertos[posicao] : 0; }
+#endif
+
     // Tabela de despacho (dispatch table) que associa nomes de comandos a funções de tratamento.
     // 'static' significa que esta tabela é compartilhada por todas as instâncias da classe.
     static ComandoInfo tabelaComandos[];
+
+private:
+    // Estados da recepção de uma linha.
+    enum EstadoRecepcao {
+        AGUARDANDO_NOME,  // Início da linha (ignorando espaços iniciais).
+        LENDO_NOME,       // Recebendo os caracteres do nome do comando.
+        LENDO_ARGUMENTOS, // Nome reconhecido, recebendo os argumentos.
+        NOME_INVALIDO,    // Nome rejeitado: o resto da linha é ignorado.
+        DESCARTANDO,      // Linha longa demais: bytes ignorados até o próximo '\n'.
+        LENDO_ENDERECO,   // Recebendo o endereço após o '@' inicial.
+        IGNORANDO,        // Linha endereçada a outra placa: ignorada sem contar como erro.
+        ENCAMINHANDO      // Linha de uma rota: cada byte é repassado diretamente à porta da rota.
+    };
+
+    void construirIndice();            // Ordena os nomes da tabela (executado uma única vez).
+    void avancarNome(char c);          // Avança o reconhecedor de nomes em um caractere.
+    void concluirNome();               // Resolve o comando ao fim do nome (espaço ou fim da linha).
+    void concluirLinha();              // Encerra a linha recebida (habilitando a transmissão, se for o caso).
+    void executarLinha();              // Executa o comando reconhecido (ou reporta o erro).
+    void receberCaractereEndereco(char c); // Acumula o endereço e decide se a linha é para esta placa.
+    void iniciarTransmissao(bool permitida); // Habilita o transmissor RS-485 (se configurado e se a resposta for permitida).
+    void encerrarTransmissao(bool permitida); // Aguarda o fim da transmissão e libera o barramento.
+    void escreverEndereco(Stream& porta, char separador); // Reescreve o prefixo "@N" exatamente como recebido.
+    void repassarRespostas();          // Devolve à Serial as respostas recebidas nas portas das rotas.
+    bool serialLivre() const { return rotaResposta == SEM_ROTA; } // Nenhuma linha de resposta de rota em andamento.
+    bool registrarLinhaInvalida();     // Conta uma linha inválida; retorna se a mensagem de erro deve ser enviada.
+    void registrarLinhaValida();       // Encerra a ressincronização ao receber uma linha válida.
+    void inserirNoIndice(const ComandoInfo* info); // Insere um comando no índice, mantendo a ordem dos nomes (erro na Serial se estiver cheio).
+#if GC_BUSCA != GC_BUSCA_PREFIXO
+    const ComandoInfo* buscarComando(const char* nome, uint8_t comprimento); // Busca conforme GC_BUSCA (nullptr se não existir).
+    int compararComando(IndiceComando i, const char* nome, uint8_t comprimento); // Ordem do comando 'i' em relação ao nome recebido.
+    bool nomeIgual(IndiceComando i, const char* nome, uint8_t comprimento);      // Se o comando 'i' tem exatamente o nome recebido.
+#endif
+    const char* nomeOrdenado(IndiceComando i) { return comandosOrdenados[i]->nome; }
+#if GC_BYTES_CHAVE > 0
+    char caractereOrdenado(IndiceComando i, uint8_t posicao) { // Caractere do nome, lido da chave sempre que possível.
+        return posicao < GC_BYTES_CHAVE ? chaves[i].inicio[posicao] : nomeOrdenado(i)[posicao];
+    }
+#else
+    char caractereOrdenado(IndiceComando i, uint8_t posicao) { return nomeOrdenado(i)[posicao]; }
+#endif
+
+    // Índice dos comandos (tabela principal e comandos registrados) ordenado alfabeticamente pelos nomes.
+    // Comandos com o mesmo prefixo ficam contíguos, então o conjunto de candidatos
+    // para o prefixo recebido até agora é sempre uma faixa [faixaInicio, faixaFim) do índice.
+    const ComandoInfo* comandosOrdenados[GC_MAX_COMANDOS];
+#if GC_BYTES_CHAVE > 0
+    ChaveComando chaves[GC_MAX_COMANDOS]; // Chave de cada comando, na mesma ordem do índice.
+#endif
+    IndiceComando numComandos;
+    bool indiceConstruido;
+#if GC_BUSCA == GC_BUSCA_LINEAR
+    void registrarAcerto(IndiceComando posicao); // Atualiza o histograma (e a ordem adaptativa) após um acerto na comparação 'posicao'.
+    uint16_t histogramaAcertos[GC_POSICOES_HISTOGRAMA];
+#if GC_ORDEM_ADAPTATIVA
+    IndiceComando ordemBusca[GC_MAX_COMANDOS]; // Posições do índice, da mais usada para a menos usada.
+    uint8_t contagemUso[GC_MAX_COMANDOS];   // Contagem de acertos (com decaimento) de cada posição de ordemBusca.
+#endif
+#elif GC_BUSCA == GC_BUSCA_INICIAL
+    char letraBalde[GC_MAX_COMANDOS];        // Primeira letra dos nomes de cada balde (em ordem).
+    IndiceComando inicioBalde[GC_MAX_COMANDOS + 1]; // Posição do primeiro comando de cada balde no índice.
+    uint8_t numBaldes;
+#elif GC_BUSCA == GC_BUSCA_HASH
+    static const IndiceComando POSICAO_VAZIA = (IndiceComando)-1;
+    IndiceComando posicaoHash[GC_POSICOES_HASH_COMANDOS]; // Posição do comando no índice (POSICAO_VAZIA = vazia).
+#endif
+
+    // Estado do reconhecedor (um autômato que avança um estado por byte recebido).
+    EstadoRecepcao estado;
+    IndiceComando faixaInicio;   // Primeiro candidato ainda compatível com o prefixo recebido.
+    IndiceComando faixaFim;      // Um após o último candidato compatível.
+    uint8_t posicaoNome;         // Quantos caracteres do nome já foram recebidos.
+    const ComandoInfo* comandoReconhecido; // Comando identificado pelo nome (nullptr se nenhum).
+    LinhaTokenizada linha;       // Linha em recepção, tokenizada à medida que os bytes chegam.
+    unsigned long ultimoByte;    // Instante (millis()) do último byte recebido.
+    uint8_t bytesLinha;          // Bytes recebidos na linha atual (incluindo espaços).
+    unsigned int transbordamentos; // Linhas descartadas por excederem GC_TAMANHO_LINHA.
+
+    // Proteção contra lixo na entrada.
+    uint8_t naoImprimiveis;      // Caracteres não imprimíveis na linha atual.
+    uint8_t errosSeguidos;       // Linhas inválidas consecutivas.
+    bool ressincronizando;       // Mensagens por linha suspensas; erros apenas contados.
+    unsigned int linhasInvalidas; // Linhas descartadas ainda não informadas no resumo.
+    unsigned long ultimoResumo;  // Instante (millis()) do último resumo de erros enviado.
+
+    // Endereçamento RS-485.
+    uint8_t endereco;            // Endereço desta placa (0 = endereçamento desativado).
+    uint8_t grupo;               // Endereço de grupo desta placa (0 = nenhum).
+    unsigned int enderecoRecebido; // Endereço lido após o '@'.
+    uint8_t digitosEndereco;     // Dígitos do endereço já recebidos.
+    bool respostaHabilitada;     // Falso para comandos de difusão/grupo (executados sem resposta).
+    int pinoDirecao;             // Pino DE/RE do transceptor (-1 = sem controle de direção).
+
+    // Roteamento.
+    Rota rotas[GC_MAX_ROTAS];
+    uint8_t numRotas;
+    uint8_t rotaAtual;           // Rota da linha em encaminhamento.
+    static const uint8_t SEM_ROTA = 0xFF;
+    uint8_t rotaAguardada;       // Rota que recebeu a última linha e ainda pode responder (SEM_ROTA = nenhuma).
+    uint8_t rotaResposta;        // Rota cuja linha de resposta está sendo repassada (SEM_ROTA = nenhuma).
+    unsigned long ultimaAtividadeRota; // Instante (millis()) do último byte encaminhado ou repassado.
+    bool difusaoEncaminhada;     // Linha de difusão: os bytes também são repassados a todas as rotas.
+
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+    // Verificação de integridade da linha (ver GC_CHECKSUM).
+    void receberDigitoChecksum(char c); // Acumula um dígito hexadecimal recebido após o '*'.
+    bool checksumValido();              // Confere o checksum da linha ao fim da recepção.
+    uint8_t checksumCalculado;   // Checksum dos bytes recebidos até o '*'.
+    uint8_t checksumRecebido;    // Valor informado após o '*'.
+    uint8_t digitosChecksum;     // Dígitos recebidos após o '*' (0xFF = formato inválido).
+    bool lendoChecksum;          // Se o '*' já foi recebido nesta linha.
+#endif
 };
 
 #endif
\ No newline at end of file
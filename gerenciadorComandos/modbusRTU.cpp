@@ -0,0 +1,214 @@
+/*
+ * modbusRTU.cpp
+ *
+ * Descrição:
+ * Implementação da interface Modbus-RTU (escravo) do gerenciador de comandos.
+ * Veja o mapa de registradores e as instruções de uso em modbusRTU.h.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "modbusRTU.h"
+#include "parametros.h"
+#include "padrao.h"
+#include "brilho.h"
+
+// Funções Modbus atendidas.
+static const uint8_t FUNCAO_LER_REGISTRADORES = 0x03;
+static const uint8_t FUNCAO_ESCREVER_REGISTRADOR = 0x06;
+static const uint8_t FUNCAO_ESCREVER_REGISTRADORES = 0x10;
+
+// Códigos de exceção Modbus.
+static const uint8_t EXCECAO_FUNCAO_ILEGAL = 0x01;
+static const uint8_t EXCECAO_ENDERECO_ILEGAL = 0x02;
+static const uint8_t EXCECAO_VALOR_ILEGAL = 0x03;
+
+// Registrador de disparo de comandos (escrita: 1 = ligarLed, 2 = desligarLed, 3 = piscarLed).
+// Os demais registradores são os parâmetros do registro (parametros.h), pelo seu endereço.
+static const uint16_t REGISTRADOR_DISPARO = 4;
+
+static void dispararComando(int valor) {
+  pararPadrao(ledPin); // Como nos comandos de texto, ligarLed/desligarLed/piscarLed encerram o padrão...
+  pararBrilho(ledPin); // ...e o controle de brilho do LED.
+  if (valor == 1 || valor == 2) { // ligarLed / desligarLed: o mesmo efeito de escrever no parâmetro "led".
+    piscarAtivo = false;
+    digitalWrite(ledPin, valor == 1 ? HIGH : LOW);
+  } else if (valor == 3) {        // piscarLed com os tempos e o número de piscadas configurados.
+    numPiscadasRestantes = piscadasConfiguradas > 0 ? piscadasConfiguradas * 2 : -1; // Duas transições por piscada, -1 = sem fim.
+    tempoAnteriorLigado = millis();
+    piscarAtivo = true;
+  }
+}
+
+uint16_t crc16Modbus(const uint8_t* dados, uint8_t tamanho, uint16_t crc) {
+  // Cálculo bit a bit: executado uma vez por quadro, não justifica uma tabela de 512 bytes na flash.
+  for (uint8_t i = 0; i < tamanho; i++) {
+    crc ^= dados[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+escravoModbus::escravoModbus(uint8_t enderecoPlaca) {
+  porta = nullptr;
+  endereco = enderecoPlaca;
+  pinoDirecao = -1;
+  silencioQuadro = 0;
+  ultimoByte = 0;
+  tamanho = 0;
+  transbordou = false;
+  errosQuadro = 0;
+}
+
+void escravoModbus::iniciar(Stream& portaModbus, unsigned long taxaTransmissao) {
+  porta = &portaModbus;
+  // 3,5 caracteres de 11 bits. Acima de 19200 bauds a norma fixa o intervalo em 1750us.
+  silencioQuadro = taxaTransmissao > 19200 ? 1750 : 38500000UL / taxaTransmissao;
+}
+
+void escravoModbus::definirPinoDirecao(int pino) {
+  pinoDirecao = pino;
+  if (pinoDirecao >= 0) {
+    pinMode(pinoDirecao, OUTPUT);
+    digitalWrite(pinoDirecao, LOW); // Transmissor desabilitado: a placa apenas escuta o barramento.
+  }
+}
+
+void escravoModbus::atualizar() {
+  if (porta == nullptr) return; // 'iniciar' ainda não foi chamada.
+
+  while (porta->available() > 0) { // Acumula os bytes do quadro em recepção.
+    uint8_t b = porta->read();
+    if (tamanho < GC_MODBUS_TAMANHO_QUADRO) {
+      quadro[tamanho++] = b;
+    } else {
+      transbordou = true; // O restante do quadro é descartado, sem ocupar mais memória.
+    }
+    ultimoByte = micros();
+  }
+
+  // O silêncio de 3,5 caracteres marca o fim do quadro.
+  if ((tamanho > 0 || transbordou) && micros() - ultimoByte >= silencioQuadro) {
+    if (transbordou) {
+      errosQuadro++;
+    } else {
+      processarQuadro();
+    }
+    tamanho = 0;
+    transbordou = false;
+  }
+}
+
+bool escravoModbus::lerRegistrador(uint16_t enderecoRegistrador, uint16_t& valor) {
+  if (enderecoRegistrador == REGISTRADOR_DISPARO) {
+    valor = 0; // O registrador de disparo não guarda valor.
+    return true;
+  }
+  int indice = parametroPorRegistrador(enderecoRegistrador);
+  if (indice < 0) return false;
+  valor = (uint16_t)lerParametro(indice);
+  return true;
+}
+
+uint8_t escravoModbus::validarEscrita(uint16_t enderecoRegistrador, uint16_t valor) {
+  int valorInteiro = (int16_t)valor;
+  if (enderecoRegistrador == REGISTRADOR_DISPARO) {
+    return (valorInteiro >= 1 && valorInteiro <= 3) ? 0 : EXCECAO_VALOR_ILEGAL;
+  }
+  int indice = parametroPorRegistrador(enderecoRegistrador);
+  if (indice < 0) return EXCECAO_ENDERECO_ILEGAL;
+  ResultadoParametro resultado = validarParametro(indice, valorInteiro);
+  if (resultado == PARAMETRO_SOMENTE_LEITURA) return EXCECAO_ENDERECO_ILEGAL;
+  if (resultado == PARAMETRO_FORA_DA_FAIXA) return EXCECAO_VALOR_ILEGAL;
+  return 0;
+}
+
+void escravoModbus::escreverRegistrador(uint16_t enderecoRegistrador, uint16_t valor) {
+  int valorInteiro = (int16_t)valor;
+  if (enderecoRegistrador == REGISTRADOR_DISPARO) {
+    dispararComando(valorInteiro);
+  } else {
+    alterarParametro(parametroPorRegistrador(enderecoRegistrador), valorInteiro);
+  }
+}
+
+void escravoModbus::processarQuadro() {
+  if (tamanho < 4) { // Menor quadro possível: endereço, função e CRC.
+    errosQuadro++;
+    return;
+  }
+  uint16_t crc = crc16Modbus(quadro, tamanho - 2);
+  if (quadro[tamanho - 2] != (crc & 0xFF) || quadro[tamanho - 1] != (crc >> 8)) { // CRC enviado com o byte baixo primeiro.
+    errosQuadro++;
+    return;
+  }
+  bool difusao = quadro[0] == 0; // Endereço 0: executado por todas as placas, sem resposta.
+  if (quadro[0] != endereco && !difusao) return; // Quadro de outra placa.
+
+  uint8_t funcao = quadro[1];
+  uint16_t inicio = ((uint16_t)quadro[2] << 8) | quadro[3];
+  uint16_t quantidade = ((uint16_t)quadro[4] << 8) | quadro[5];
+
+  if (funcao == FUNCAO_LER_REGISTRADORES && tamanho == 8) {
+    if (difusao) return; // Leitura por difusão não é permitida pela norma.
+    // A resposta usa o mesmo buffer: endereço, função, contagem de bytes, dados e CRC.
+    if (quantidade == 0 || quantidade > (GC_MODBUS_TAMANHO_QUADRO - 5) / 2) {
+      responderExcecao(funcao, EXCECAO_VALOR_ILEGAL);
+      return;
+    }
+    for (uint16_t i = 0; i < quantidade; i++) {
+      uint16_t valor;
+      if (!lerRegistrador(inicio + i, valor)) {
+        responderExcecao(funcao, EXCECAO_ENDERECO_ILEGAL);
+        return;
+      }
+      quadro[3 + i * 2] = valor >> 8;
+      quadro[4 + i * 2] = valor & 0xFF;
+    }
+    quadro[2] = quantidade * 2;
+    enviarResposta(3 + quantidade * 2);
+  } else if (funcao == FUNCAO_ESCREVER_REGISTRADOR && tamanho == 8) {
+    uint8_t excecao = validarEscrita(inicio, quantidade); // Na função 0x06 o segundo campo é o valor.
+    if (excecao != 0) {
+      if (!difusao) responderExcecao(funcao, excecao);
+      return;
+    }
+    escreverRegistrador(inicio, quantidade);
+    if (!difusao) enviarResposta(6); // A resposta repete a requisição.
+  } else if (funcao == FUNCAO_ESCREVER_REGISTRADORES && tamanho >= 9 && quadro[6] == quantidade * 2 && tamanho == 9 + quadro[6]) {
+    // Todos os valores são validados antes da primeira escrita: a transação é aplicada inteira ou recusada.
+    for (uint16_t i = 0; i < quantidade; i++) {
+      uint8_t excecao = validarEscrita(inicio + i, ((uint16_t)quadro[7 + i * 2] << 8) | quadro[8 + i * 2]);
+      if (excecao != 0) {
+        if (!difusao) responderExcecao(funcao, excecao);
+        return;
+      }
+    }
+    for (uint16_t i = 0; i < quantidade; i++) {
+      escreverRegistrador(inicio + i, ((uint16_t)quadro[7 + i * 2] << 8) | quadro[8 + i * 2]);
+    }
+    if (!difusao) enviarResposta(6); // Endereço, função, registrador inicial e quantidade.
+  } else if (!difusao) {
+    responderExcecao(funcao, EXCECAO_FUNCAO_ILEGAL);
+  }
+}
+
+void escravoModbus::responderExcecao(uint8_t funcao, uint8_t codigo) {
+  quadro[1] = funcao | 0x80; // Bit mais alto da função indica exceção.
+  quadro[2] = codigo;
+  enviarResposta(3);
+}
+
+void escravoModbus::enviarResposta(uint8_t tamanhoResposta) {
+  uint16_t crc = crc16Modbus(quadro, tamanhoResposta);
+  quadro[tamanhoResposta++] = crc & 0xFF;
+  quadro[tamanhoResposta++] = crc >> 8;
+  if (pinoDirecao >= 0) digitalWrite(pinoDirecao, HIGH); // Habilita o transmissor RS-485.
+  porta->write(quadro, tamanhoResposta);
+  if (pinoDirecao >= 0) {
+    porta->flush();                 // Aguarda o último byte sair da UART...
+    digitalWrite(pinoDirecao, LOW); // ...e só então libera o barramento.
+  }
+}
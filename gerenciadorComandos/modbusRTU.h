@@ -0,0 +1,82 @@
+/*
+ * modbusRTU.h
+ *
+ * Descrição:
+ * Interface Modbus-RTU (escravo) opcional para o gerenciador de comandos.
+ * Expõe os parâmetros dos comandos (tempos e número de piscadas usados por
+ * 'piscarLed', estado do LED) e o disparo dos comandos como um mapa de
+ * registradores (holding registers), para integração com CLPs.
+ *
+ * Funcionalidade Principal:
+ * Os quadros binários são delimitados pelo silêncio de 3,5 caracteres na linha,
+ * validados pelo CRC16 do Modbus e respondidos em uma única transação, mesmo
+ * quando vários registradores são lidos ou escritos de uma vez.
+ * Funções suportadas: 0x03 (ler registradores), 0x06 (escrever um registrador)
+ * e 0x10 (escrever vários registradores).
+ *
+ * Mapa de registradores (definido pelo registro de parâmetros, parametros.cpp):
+ *   0 - tempo ligado (ms)               1 - tempo desligado (ms)
+ *   2 - número de piscadas (0 = sem fim) 3 - estado do LED (0/1, escrita liga/desliga)
+ *   4 - disparo de comando (escrita: 1 = ligarLed, 2 = desligarLed, 3 = piscarLed)
+ *   5 - piscar ativo (somente leitura)  6 - transições restantes (somente leitura)
+ *
+ * Utilização:
+ * 1. Crie um objeto escravoModbus informando o endereço da placa.
+ * 2. Chame 'iniciar' no setup() com a porta e a taxa de transmissão.
+ * 3. Chame 'atualizar' a cada execução do loop().
+ * A porta usada pelo Modbus não pode ser a mesma usada pelos comandos de texto.
+ */
+
+#ifndef MODBUS_RTU_H
+#define MODBUS_RTU_H
+
+#include <Arduino.h>
+
+// Tamanho máximo de um quadro Modbus (requisição ou resposta).
+// 64 bytes permitem ler ou escrever até 29 registradores em uma transação.
+#ifndef GC_MODBUS_TAMANHO_QUADRO
+#define GC_MODBUS_TAMANHO_QUADRO 64
+#endif
+
+// Classe escravoModbus.
+// Atende requisições Modbus-RTU endereçadas a esta placa em uma porta serial.
+class escravoModbus {
+public:
+    escravoModbus(uint8_t endereco);
+
+    // Associa a porta e calcula o tempo de silêncio (3,5 caracteres) que delimita os quadros.
+    void iniciar(Stream& porta, unsigned long taxaTransmissao);
+
+    // Configura o pino DE/RE de um transceptor RS-485 half-duplex (-1 desativa).
+    void definirPinoDirecao(int pino);
+
+    // Recebe os bytes disponíveis e responde ao quadro completo. Deve ser chamada a cada loop().
+    void atualizar();
+
+    // Quadros descartados por CRC inválido ou por excederem GC_MODBUS_TAMANHO_QUADRO.
+    unsigned int quadrosInvalidos() const { return errosQuadro; }
+
+private:
+    void processarQuadro();              // Valida e executa o quadro recebido.
+    void responderExcecao(uint8_t funcao, uint8_t codigo);
+    void enviarResposta(uint8_t tamanho); // Acrescenta o CRC e transmite 'quadro'.
+    bool lerRegistrador(uint16_t endereco, uint16_t& valor);
+    uint8_t validarEscrita(uint16_t endereco, uint16_t valor); // Retorna 0 ou o código de exceção.
+    void escreverRegistrador(uint16_t endereco, uint16_t valor);
+
+    Stream* porta;
+    uint8_t endereco;                    // Endereço desta placa (1 a 247).
+    int pinoDirecao;                     // Pino DE/RE do transceptor (-1 = sem controle de direção).
+    unsigned long silencioQuadro;        // Silêncio (em microssegundos) que encerra um quadro.
+    unsigned long ultimoByte;            // Instante (micros()) do último byte recebido.
+    uint8_t quadro[GC_MODBUS_TAMANHO_QUADRO]; // Quadro recebido (reutilizado para a resposta).
+    uint8_t tamanho;                     // Bytes recebidos no quadro atual.
+    bool transbordou;                    // Quadro maior que o buffer: descartado ao fim.
+    unsigned int errosQuadro;
+};
+
+// Calcula o CRC16 do Modbus (polinômio 0xA001, valor inicial 0xFFFF).
+// Para continuar um CRC sobre mais dados, passe o resultado anterior como 'crc'.
+uint16_t crc16Modbus(const uint8_t* dados, uint8_t tamanho, uint16_t crc = 0xFFFF);
+
+#endif
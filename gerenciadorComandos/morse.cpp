@@ -0,0 +1,115 @@
+/*
+ * morse.cpp
+ *
+ * Descrição:
+ * Conversão de texto para código Morse. Veja morse.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "padrao.h"
+#include "morse.h"
+
+// Cada símbolo ocupa um byte: um bit 1 marcador seguido dos sinais, do primeiro ao último (0 = ponto, 1 = traço).
+// Ex: "-." (N) = 0b110. Calculado na compilação a partir da grafia do símbolo.
+constexpr uint8_t simboloMorse(const char* sinais, uint8_t acumulado = 1) {
+  return *sinais == '\0' ? acumulado : simboloMorse(sinais + 1, (acumulado << 1) | (*sinais == '-' ? 1 : 0));
+}
+
+static const uint8_t tabelaLetras[26] PROGMEM = {
+  simboloMorse(".-"),   simboloMorse("-..."), simboloMorse("-.-."), simboloMorse("-.."),  simboloMorse("."),    // A-E
+  simboloMorse("..-."), simboloMorse("--."),  simboloMorse("...."), simboloMorse(".."),   simboloMorse(".---"), // F-J
+  simboloMorse("-.-"),  simboloMorse(".-.."), simboloMorse("--"),   simboloMorse("-."),   simboloMorse("---"),  // K-O
+  simboloMorse(".--."), simboloMorse("--.-"), simboloMorse(".-."),  simboloMorse("..."),  simboloMorse("-"),    // P-T
+  simboloMorse("..-"),  simboloMorse("...-"), simboloMorse(".--"),  simboloMorse("-..-"), simboloMorse("-.--"), // U-Y
+  simboloMorse("--.."),                                                                                         // Z
+};
+static const uint8_t tabelaAlgarismos[10] PROGMEM = {
+  simboloMorse("-----"), simboloMorse(".----"), simboloMorse("..---"), simboloMorse("...--"), simboloMorse("....-"), // 0-4
+  simboloMorse("....."), simboloMorse("-...."), simboloMorse("--..."), simboloMorse("---.."), simboloMorse("----."), // 5-9
+};
+static_assert(simboloMorse("...") == 0b1000 && simboloMorse("-.") == 0b110, "Codificação dos símbolos Morse");
+
+// Durações em unidades do sequenciador de padrões.
+static const uint16_t PONTO = GC_UNIDADE_MORSE / GC_UNIDADE_PADRAO;
+static_assert(GC_UNIDADE_MORSE / GC_UNIDADE_PADRAO >= 1 && 7L * GC_UNIDADE_MORSE / GC_UNIDADE_PADRAO <= 0x7FFF,
+              "GC_UNIDADE_MORSE incompatível com GC_UNIDADE_PADRAO");
+
+static char mensagem[GC_TAMANHO_MORSE + 1];
+static uint8_t proximoCaractere = 0;
+static uint8_t trecho[5 * 2 * 2]; // Um caractere: até 5 sinais, cada um com a duração ligado e a pausa seguinte (até 2 bytes cada).
+
+// Símbolo do caractere (0 = caractere sem símbolo).
+static uint8_t simboloDoCaractere(char c) {
+  if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+  if (c >= 'A' && c <= 'Z') return pgm_read_byte(&tabelaLetras[c - 'A']);
+  if (c >= '0' && c <= '9') return pgm_read_byte(&tabelaAlgarismos[c - '0']);
+  return 0;
+}
+
+// Converte o próximo caractere da mensagem (os espaços apenas alongam a pausa do caractere anterior).
+static uint8_t gerarTrecho(const uint8_t*& dados) {
+  if (mensagem[proximoCaractere] == '\0') return 0; // Fim da mensagem.
+  uint8_t simbolo = simboloDoCaractere(mensagem[proximoCaractere++]);
+  bool fimPalavra = false;
+  while (mensagem[proximoCaractere] == ' ') {
+    proximoCaractere++;
+    fimPalavra = true;
+  }
+  if (mensagem[proximoCaractere] == '\0') fimPalavra = true; // Pausa de palavra também antes da repetição.
+
+  uint8_t sinais = 0; // Número de sinais: posição do bit marcador.
+  while ((simbolo >> (sinais + 1)) != 0) sinais++;
+  uint8_t tamanho = 0;
+  for (int8_t i = sinais - 1; i >= 0; i--) {
+    tamanho += codificarDuracao((simbolo & (1 << i)) ? 3 * PONTO : PONTO, trecho + tamanho);
+    uint16_t pausa = i > 0 ? PONTO : (fimPalavra ? 7 * PONTO : 3 * PONTO);
+    tamanho += codificarDuracao(pausa, trecho + tamanho);
+  }
+  dados = trecho;
+  return tamanho;
+}
+
+static void reiniciarMensagem() {
+  proximoCaractere = 0;
+}
+
+static const GeradorPadrao geradorMorse = { gerarTrecho, reiniciarMensagem };
+
+// Trata o comando "morse".
+static void tratarMorse(Comando comando) {
+  if (comando.numValores == 0) {
+    pararPadrao(ledPin);
+    digitalWrite(ledPin, LOW);
+    return;
+  }
+  // As palavras chegam como valores separados; são unidas de novo com um espaço.
+  unsigned int tamanho = 0;
+  for (int v = 0; v < comando.numValores; v++) {
+    const char* palavra = comando.valores[v];
+    for (uint8_t i = 0; palavra[i] != '\0'; i++) {
+      if (simboloDoCaractere(palavra[i]) == 0) {
+        Serial.print("Erro: Caractere sem código Morse: ");
+        Serial.println(palavra[i]);
+        return;
+      }
+    }
+    tamanho += (v > 0 ? 1 : 0) + strlen(palavra);
+  }
+  if (tamanho > GC_TAMANHO_MORSE) {
+    Serial.print("Erro: Mensagem longa demais (máximo de ");
+    Serial.print(GC_TAMANHO_MORSE);
+    Serial.println(" caracteres).");
+    return;
+  }
+  pararPadrao(ledPin); // A mensagem anterior deixa de usar o texto antes que ele seja substituído.
+  tamanho = 0;
+  for (int v = 0; v < comando.numValores; v++) {
+    if (v > 0) mensagem[tamanho++] = ' ';
+    strcpy(mensagem + tamanho, comando.valores[v]);
+    tamanho += strlen(comando.valores[v]);
+  }
+  mensagem[tamanho] = '\0';
+  tocarPadraoGerado(ledPin, &geradorMorse, 0);
+}
+REGISTRAR_COMANDO("morse", tratarMorse, "<texto>");
@@ -0,0 +1,37 @@
+/*
+ * morse.h
+ *
+ * Descrição:
+ * Transmite um texto curto em código Morse pelo LED (ex: o código de um erro ou o número
+ * do nó), para ser lido pelo técnico em campo, com o comando "morse <texto>".
+ *
+ * Funcionalidade Principal:
+ * As letras (A a Z, sem distinção de maiúsculas) e os algarismos são convertidos por tabelas
+ * montadas na compilação, na memória flash. A mensagem é tocada pelo sequenciador de padrões
+ * (padrao.h) e repetida sem fim, com uma pausa de palavra entre as repetições. Apenas o texto
+ * é guardado: cada caractere é convertido para o formato dos padrões quando o anterior termina
+ * de ser tocado, de modo que a RAM usada não depende do tamanho da mensagem convertida.
+ * Tempos: ponto = GC_UNIDADE_MORSE ms, traço = 3 pontos; 1 ponto entre os sinais de uma letra,
+ * 3 entre as letras e 7 entre as palavras.
+ * "morse" sem texto encerra a transmissão (assim como "ligarLed", "desligarLed" e "piscarLed").
+ *
+ * Exemplo de Comando:
+ * "morse E12" (código de erro 12)
+ * "morse no 7"
+ */
+
+#ifndef MORSE_H
+#define MORSE_H
+
+#include <Arduino.h>
+
+// Duração do ponto, em milissegundos (120ms: cerca de 10 palavras por minuto).
+#ifndef GC_UNIDADE_MORSE
+#define GC_UNIDADE_MORSE 120
+#endif
+// Caracteres guardados da mensagem (incluindo os espaços entre as palavras).
+#ifndef GC_TAMANHO_MORSE
+#define GC_TAMANHO_MORSE 32
+#endif
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * padrao.cpp
+ *
+ * Descrição:
+ * Sequenciador de padrões de liga/desliga. Veja padrao.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "padrao.h"
+#include "brilho.h"
+
+// Durações em unidades de GC_UNIDADE_PADRAO ms; cada valor precisa ser menor que 128 (um byte).
+#define GC_MS(ms) ((ms) / GC_UNIDADE_PADRAO)
+
+// Biblioteca de padrões (na memória flash).
+static const uint8_t dadosPiscar[] PROGMEM = { GC_MS(500), GC_MS(500) };
+static const uint8_t dadosRapido[] PROGMEM = { GC_MS(100), GC_MS(100) };
+static const uint8_t dadosDuplo[] PROGMEM = { GC_MS(100), GC_MS(100), GC_MS(100), GC_MS(700) };
+static const uint8_t dadosTriplo[] PROGMEM = { GC_MS(100), GC_MS(100), GC_MS(100), GC_MS(100), GC_MS(100), GC_MS(600) };
+static const uint8_t dadosBatimento[] PROGMEM = { GC_MS(100), GC_MS(150), GC_MS(100), GC_MS(850) };
+static const uint8_t dadosSos[] PROGMEM = { // Ponto 150ms, traço 450ms, 1050ms entre as repetições.
+  GC_MS(150), GC_MS(150), GC_MS(150), GC_MS(150), GC_MS(150), GC_MS(450),
+  GC_MS(450), GC_MS(150), GC_MS(450), GC_MS(150), GC_MS(450), GC_MS(450),
+  GC_MS(150), GC_MS(150), GC_MS(150), GC_MS(150), GC_MS(150), GC_MS(1050),
+};
+static_assert(GC_MS(1050) > 0 && GC_MS(1050) < 128, "GC_UNIDADE_PADRAO incompatível com a biblioteca de padrões");
+
+static const char nomePiscar[] PROGMEM = "piscar";
+static const char nomeRapido[] PROGMEM = "rapido";
+static const char nomeDuplo[] PROGMEM = "duplo";
+static const char nomeTriplo[] PROGMEM = "triplo";
+static const char nomeBatimento[] PROGMEM = "batimento";
+static const char nomeSos[] PROGMEM = "sos";
+
+struct PadraoNomeado {
+  const char* nome;      // Na memória flash.
+  const uint8_t* dados;  // Na memória flash.
+  uint8_t tamanho;       // Bytes em 'dados'.
+};
+
+static const PadraoNomeado tabelaPadroes[] PROGMEM = {
+  {nomePiscar,    dadosPiscar,    sizeof(dadosPiscar)},
+  {nomeRapido,    dadosRapido,    sizeof(dadosRapido)},
+  {nomeDuplo,     dadosDuplo,     sizeof(dadosDuplo)},
+  {nomeTriplo,    dadosTriplo,    sizeof(dadosTriplo)},
+  {nomeBatimento, dadosBatimento, sizeof(dadosBatimento)},
+  {nomeSos,       dadosSos,       sizeof(dadosSos)},
+};
+static const uint8_t totalPadroes = sizeof(tabelaPadroes) / sizeof(tabelaPadroes[0]);
+
+// Listas recebidas pelo comando, já compiladas (tamanho 0 = posição livre).
+struct PadraoUsuario {
+  uint8_t dados[GC_TAMANHO_PADRAO];
+  uint8_t tamanho;
+};
+static PadraoUsuario padroesUsuario[GC_PADROES_USUARIO];
+
+static const uint8_t CANAL_LIVRE = 0xFF;
+
+struct CanalPadrao {
+  uint8_t pino;             // CANAL_LIVRE = canal sem padrão.
+  const uint8_t* dados;     // Padrão tocado (compartilhado entre os canais).
+  bool naFlash;             // 'dados' na memória flash (biblioteca) ou na RAM (lista do comando).
+  uint8_t tamanho;
+  uint8_t posicao;          // Próximo byte a decodificar.
+  bool ligado;              // Nível da etapa atual.
+  uint16_t repeticoes;      // Repetições restantes, contando a atual (0 = sem fim).
+  const GeradorPadrao* gerador; // Padrão gerado por trechos durante a execução (nullptr = 'dados' completo).
+  unsigned long inicio;     // Instante (millis()) do início da etapa atual.
+  unsigned long duracao;    // Duração da etapa atual, em milissegundos.
+};
+static CanalPadrao canais[GC_CANAIS_PADRAO];
+static bool canaisIniciados = false;
+
+static void iniciarCanais() {
+  if (canaisIniciados) return;
+  for (uint8_t i = 0; i < GC_CANAIS_PADRAO; i++) canais[i].pino = CANAL_LIVRE;
+  canaisIniciados = true;
+}
+
+static uint8_t lerByte(const CanalPadrao& canal, uint8_t posicao) {
+  return canal.naFlash ? pgm_read_byte(canal.dados + posicao) : canal.dados[posicao];
+}
+
+// Decodifica a próxima duração do padrão (1 ou 2 bytes), em milissegundos.
+static unsigned long proximaDuracao(CanalPadrao& canal) {
+  uint16_t unidades = lerByte(canal, canal.posicao++);
+  if (unidades & 0x80) {
+    unidades = ((unidades & 0x7F) << 8) | lerByte(canal, canal.posicao++);
+  }
+  return (unsigned long)unidades * GC_UNIDADE_PADRAO;
+}
+
+// Inicia a etapa atual: aplica o nível e calcula quando ela termina.
+static void iniciarEtapa(CanalPadrao& canal) {
+  canal.duracao = proximaDuracao(canal);
+  digitalWrite(canal.pino, canal.ligado ? HIGH : LOW);
+}
+
+uint8_t codificarDuracao(uint16_t unidades, uint8_t* dados) {
+  if (unidades <= 0x7F) {
+    dados[0] = unidades;
+    return 1;
+  }
+  dados[0] = 0x80 | (unidades >> 8);
+  dados[1] = unidades & 0xFF;
+  return 2;
+}
+
+// Busca o próximo trecho de um padrão gerado. Retorna false no fim do padrão.
+static bool proximoTrecho(CanalPadrao& canal) {
+  if (canal.gerador == nullptr) return false;
+  canal.tamanho = canal.gerador->gerar(canal.dados);
+  canal.posicao = 0;
+  return canal.tamanho > 0;
+}
+
+// Volta ao início do padrão (repetições).
+static void reiniciarPadrao(CanalPadrao& canal) {
+  canal.posicao = 0;
+  if (canal.gerador != nullptr) {
+    canal.gerador->reiniciar();
+    canal.tamanho = canal.gerador->gerar(canal.dados);
+  }
+}
+
+void pararPadrao(uint8_t pino) {
+  iniciarCanais();
+  for (uint8_t i = 0; i < GC_CANAIS_PADRAO; i++) {
+    if (canais[i].pino == pino) canais[i].pino = CANAL_LIVRE;
+  }
+}
+
+void atualizarPadroes() {
+  if (!canaisIniciados) return; // Nenhum padrão foi iniciado.
+  unsigned long agora = millis();
+  for (uint8_t i = 0; i < GC_CANAIS_PADRAO; i++) {
+    CanalPadrao& canal = canais[i];
+    if (canal.pino == CANAL_LIVRE || agora - canal.inicio < canal.duracao) continue; // A única comparação por canal, fora das trocas.
+    canal.inicio += canal.duracao; // A partir do fim previsto da etapa: os atrasos do loop() não se acumulam.
+    canal.ligado = !canal.ligado;
+    if (canal.posicao >= canal.tamanho && !proximoTrecho(canal)) { // Fim do padrão.
+      if (canal.repeticoes == 1) {
+        digitalWrite(canal.pino, LOW);
+        canal.pino = CANAL_LIVRE;
+        continue;
+      }
+      if (canal.repeticoes > 1) canal.repeticoes--;
+      reiniciarPadrao(canal);
+    }
+    iniciarEtapa(canal);
+  }
+}
+
+// Compila uma lista "d1,d2,..." (milissegundos) para o formato dos padrões.
+// Retorna o número de bytes, ou 0 (com a mensagem de erro) se a lista for inválida.
+static uint8_t compilarLista(const char* texto, uint8_t* dados) {
+  uint8_t tamanho = 0;
+  uint8_t duracoes = 0;
+  while (true) {
+    char* fim;
+    long ms = strtol(texto, &fim, 10);
+    long unidades = ms / GC_UNIDADE_PADRAO;
+    if (fim == texto || (*fim != ',' && *fim != '\0') || unidades < 1 || unidades > 0x7FFF) {
+      Serial.print("Erro: Durações de ");
+      Serial.print(GC_UNIDADE_PADRAO);
+      Serial.print(" a ");
+      Serial.print(0x7FFFL * GC_UNIDADE_PADRAO);
+      Serial.println("ms, separadas por vírgula.");
+      return 0;
+    }
+    if (tamanho + (unidades > 0x7F ? 2 : 1) > GC_TAMANHO_PADRAO) {
+      Serial.println("Erro: Padrão longo demais.");
+      return 0;
+    }
+    tamanho += codificarDuracao(unidades, dados + tamanho);
+    duracoes++;
+    if (*fim == '\0') break;
+    texto = fim + 1;
+  }
+  if (duracoes % 2 != 0) {
+    Serial.println("Erro: O padrão deve ter um número par de durações (ligado, desligado, ...).");
+    return 0;
+  }
+  return tamanho;
+}
+
+// Guarda uma lista compilada, reaproveitando uma cópia igual ou uma posição sem canais.
+static const uint8_t* guardarLista(const uint8_t* dados, uint8_t tamanho, uint8_t pinoSubstituido) {
+  PadraoUsuario* livre = nullptr;
+  for (uint8_t p = 0; p < GC_PADROES_USUARIO; p++) {
+    PadraoUsuario& padrao = padroesUsuario[p];
+    if (padrao.tamanho == tamanho && memcmp(padrao.dados, dados, tamanho) == 0) return padrao.dados;
+    bool emUso = false;
+    for (uint8_t i = 0; i < GC_CANAIS_PADRAO; i++) {
+      if (canais[i].pino != CANAL_LIVRE && canais[i].pino != pinoSubstituido && canais[i].dados == padrao.dados) emUso = true;
+    }
+    if (!emUso && livre == nullptr) livre = &padrao;
+  }
+  if (livre == nullptr) return nullptr;
+  memcpy(livre->dados, dados, tamanho);
+  livre->tamanho = tamanho;
+  return livre->dados;
+}
+
+// Coloca o padrão 'novo' no canal do pino (o canal do próprio pino, se houver, ou o primeiro livre) e o inicia.
+static bool iniciarCanal(uint8_t pino, CanalPadrao& novo, uint16_t repeticoes) {
+  CanalPadrao* canal = nullptr;
+  for (uint8_t i = 0; i < GC_CANAIS_PADRAO; i++) {
+    if (canais[i].pino == pino) canal = &canais[i];
+  }
+  for (uint8_t i = 0; i < GC_CANAIS_PADRAO && canal == nullptr; i++) {
+    if (canais[i].pino == CANAL_LIVRE) canal = &canais[i];
+  }
+  if (canal == nullptr) {
+    Serial.println("Erro: Todos os canais de padrão estão em uso.");
+    return false;
+  }
+  if (pino == ledPin) piscarAtivo = false; // O padrão substitui o piscarLed...
+  pararBrilho(pino);                        // ...e o controle de brilho do pino.
+  novo.pino = pino;
+  novo.posicao = 0;
+  novo.ligado = true;
+  novo.repeticoes = repeticoes;
+  novo.inicio = millis();
+  pinMode(pino, OUTPUT);
+  *canal = novo;
+  iniciarEtapa(*canal);
+  return true;
+}
+
+bool tocarPadraoGerado(uint8_t pino, const GeradorPadrao* gerador, uint16_t repeticoes) {
+  iniciarCanais();
+  CanalPadrao novo;
+  novo.naFlash = false;
+  novo.gerador = gerador;
+  gerador->reiniciar();
+  novo.tamanho = gerador->gerar(novo.dados);
+  if (novo.tamanho == 0) return false; // Padrão vazio.
+  return iniciarCanal(pino, novo, repeticoes);
+}
+
+static void listarPadroes() {
+  Serial.print("Padrões:");
+  for (uint8_t i = 0; i < totalPadroes; i++) {
+    PadraoNomeado padrao;
+    memcpy_P(&padrao, &tabelaPadroes[i], sizeof(padrao));
+    Serial.print(' ');
+    Serial.print((const __FlashStringHelper*)padrao.nome);
+  }
+  Serial.println();
+}
+
+// Trata o comando "padrao".
+static void tratarPadrao(Comando comando) {
+  iniciarCanais();
+  if (comando.numValores == 0) {
+    listarPadroes();
+    return;
+  }
+  long pino = comando.valores[0].toInt();
+  long repeticoes = comando.numValores >= 3 ? comando.valores[2].toInt() : 0;
+  if (comando.numValores > 3 || pino < 0 || pino >= CANAL_LIVRE || repeticoes < 0 || repeticoes > 65535L) {
+    Serial.println("Erro: Use 'padrao <pino> <nome|d1,d2,...> [repeticoes]' ou 'padrao <pino>' para encerrar.");
+    return;
+  }
+  if (comando.numValores == 1) {
+    pararPadrao(pino);
+    digitalWrite(pino, LOW);
+    return;
+  }
+
+  CanalPadrao novo;
+  novo.naFlash = false;
+  const char* texto = comando.valores[1];
+  for (uint8_t i = 0; i < totalPadroes && !novo.naFlash; i++) {
+    PadraoNomeado padrao;
+    memcpy_P(&padrao, &tabelaPadroes[i], sizeof(padrao));
+    if (strcmp_P(texto, padrao.nome) == 0) {
+      novo.dados = padrao.dados;
+      novo.tamanho = padrao.tamanho;
+      novo.naFlash = true;
+    }
+  }
+  if (!novo.naFlash) {
+    if (!isDigit(texto[0])) {
+      Serial.print("Erro: Padrão desconhecido: ");
+      Serial.println(texto);
+      listarPadroes();
+      return;
+    }
+    uint8_t dados[GC_TAMANHO_PADRAO];
+    novo.tamanho = compilarLista(texto, dados);
+    if (novo.tamanho == 0) return;
+    novo.dados = guardarLista(dados, novo.tamanho, pino);
+    if (novo.dados == nullptr) {
+      Serial.println("Erro: Sem espaço para outra lista de durações (encerre um padrão com 'padrao <pino>').");
+      return;
+    }
+  }
+
+  novo.gerador = nullptr;
+  iniciarCanal(pino, novo, repeticoes);
+}
+REGISTRAR_COMANDO("padrao", tratarPadrao, "<pino> [nome|d1,d2,...] [repeticoes]");
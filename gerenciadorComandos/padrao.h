@@ -0,0 +1,77 @@
+/*
+ * padrao.h
+ *
+ * Descrição:
+ * Sequências arbitrárias de liga/desliga (piscada dupla, SOS, batimento cardíaco, ...)
+ * em qualquer pino, com o comando "padrao", sem ocupar o loop() com delay().
+ *
+ * Funcionalidade Principal:
+ * Um padrão é uma lista de durações alternadas: ligado, desligado, ligado, desligado, ...
+ * O comando aceita o nome de um padrão da biblioteca na memória flash (tabelaPadroes em
+ * padrao.cpp) ou uma lista de durações em milissegundos separadas por vírgula, que é
+ * compilada para o mesmo formato compacto: cada duração é a distância até a próxima troca,
+ * em unidades de GC_UNIDADE_PADRAO ms, com 1 byte (até 127 unidades) ou 2 bytes (até 32767
+ * unidades, primeiro byte com o bit 7 ligado).
+ *
+ * Cada pino em execução ocupa um canal (GC_CANAIS_PADRAO), que aponta para o padrão: vários
+ * canais podem tocar o mesmo padrão, e listas iguais enviadas para pinos diferentes usam a
+ * mesma cópia na RAM (GC_PADROES_USUARIO listas diferentes ao mesmo tempo).
+ * A duração da etapa atual de cada canal é decodificada apenas na troca, de modo que a cada
+ * chamada de 'atualizarPadroes' cada canal faz uma única comparação de tempo.
+ * Padrões longos (ex: o comando "morse") também podem ser gerados por trechos durante a
+ * execução (GeradorPadrao), sem ocupar RAM proporcional ao seu tamanho.
+ *
+ * Utilização:
+ * "padrao <pino> <nome|d1,d2,...> [repeticoes]" inicia o padrão no pino (repeticoes = 0 ou
+ * omitido: repete sem fim). Ao final das repetições o pino é desligado.
+ * "padrao <pino>" encerra o padrão do pino, e "padrao" lista os padrões da biblioteca.
+ * "ligarLed", "desligarLed" e "piscarLed" encerram o padrão do pino do LED.
+ *
+ * Exemplo de Comando:
+ * "padrao 13 sos 3" (SOS três vezes no LED)
+ * "padrao 7 100,100,100,700" (piscada dupla sem fim no pino 7)
+ */
+
+#ifndef PADRAO_H
+#define PADRAO_H
+
+#include <Arduino.h>
+
+// Resolução das durações, em milissegundos.
+#ifndef GC_UNIDADE_PADRAO
+#define GC_UNIDADE_PADRAO 10
+#endif
+// Pinos tocando padrões ao mesmo tempo.
+#ifndef GC_CANAIS_PADRAO
+#define GC_CANAIS_PADRAO 4
+#endif
+// Listas de durações recebidas pelo comando guardadas ao mesmo tempo, e o tamanho de cada uma (em bytes compilados).
+#ifndef GC_PADROES_USUARIO
+#define GC_PADROES_USUARIO 2
+#endif
+#ifndef GC_TAMANHO_PADRAO
+#define GC_TAMANHO_PADRAO 24
+#endif
+
+// Padrão gerado por trechos durante a execução (ex: o comando "morse"), para que padrões longos
+// não precisem ser guardados inteiros na RAM.
+struct GeradorPadrao {
+  // Aponta 'dados' para o próximo trecho, já no formato dos padrões, e retorna o número de bytes (0 = fim do padrão).
+  // O trecho deve continuar válido até a próxima chamada, e ter um número par de durações.
+  uint8_t (*gerar)(const uint8_t*& dados);
+  void (*reiniciar)(); // Volta ao início do padrão (chamada antes do primeiro trecho e a cada repetição).
+};
+
+// Inicia um padrão gerado no pino (repeticoes = 0: sem fim). Retorna false se não houver canal livre.
+bool tocarPadraoGerado(uint8_t pino, const GeradorPadrao* gerador, uint16_t repeticoes);
+
+// Escreve uma duração (em unidades de GC_UNIDADE_PADRAO, até 32767) no formato dos padrões. Retorna o número de bytes (1 ou 2).
+uint8_t codificarDuracao(uint16_t unidades, uint8_t* dados);
+
+// Encerra o padrão do pino, se houver (o pino fica no estado atual).
+void pararPadrao(uint8_t pino);
+
+// Avança os padrões em execução. Deve ser chamada a cada loop().
+void atualizarPadroes();
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * parametros.cpp
+ *
+ * Descrição:
+ * Tabela de parâmetros do gerenciador de comandos e funções de acesso.
+ * Veja parametros.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "parametros.h"
+#include "diario.h"
+#include "eventos.h"
+#include "padrao.h"
+#include "brilho.h"
+
+int piscadasConfiguradas = 0; // Sem número de piscadas configurado: o piscar disparado pelo Modbus não tem fim.
+
+// Leituras e ações dos parâmetros calculados.
+static int lerEstadoLed() {
+  return pinoLigado(ledPin) ? 1 : 0; // Sem amostrar a modulação do brilho.
+}
+
+static void escreverEstadoLed(int valor) {
+  piscarAtivo = false; // Assim como ligarLed/desligarLed, interrompe o piscar...
+  pararPadrao(ledPin); // ...o padrão em execução no LED...
+  pararBrilho(ledPin); // ...e o controle de brilho.
+  digitalWrite(ledPin, valor ? HIGH : LOW);
+}
+
+// Nomes dos parâmetros (na memória flash).
+static const char nomeTempoLigado[] PROGMEM = "tempoLigado";
+static const char nomeTempoDesligado[] PROGMEM = "tempoDesligado";
+static const char nomePiscadas[] PROGMEM = "piscadas";
+static const char nomeLed[] PROGMEM = "led";
+static const char nomePiscarAtivo[] PROGMEM = "piscarAtivo";
+static const char nomeTransicoes[] PROGMEM = "transicoesRestantes";
+
+// Tabela de parâmetros. O hash de cada nome é calculado na compilação (hashNomeConstante),
+// e o registrador é o endereço usado pela interface Modbus.
+// A faixa de "transicoesRestantes" (somente leitura) informa os valores possíveis: -1 = piscar sem fim,
+// e no máximo duas transições para cada uma das 16383 piscadas aceitas por "piscadas".
+// Os parâmetros persistentes são restaurados na ordem da tabela: "led" precede "piscarAtivo",
+// pois escrever "led" interrompe o piscar.
+static const ParametroInfo tabelaParametros[] PROGMEM = {
+  // nome,             hash,                                     tipo,               leitura, salvo, reg, mínimo, máximo, variável,              ler,          aoEscrever
+  {nomeTempoLigado,    hashNomeConstante("tempoLigado"),         PARAMETRO_INTEIRO,  false,   true,  0,   1,      32767,  &tempoLigadoAtual,     nullptr,      nullptr},
+  {nomeTempoDesligado, hashNomeConstante("tempoDesligado"),      PARAMETRO_INTEIRO,  false,   true,  1,   1,      32767,  &tempoDesligadoAtual,  nullptr,      nullptr},
+  {nomePiscadas,       hashNomeConstante("piscadas"),            PARAMETRO_INTEIRO,  false,   true,  2,   0,      16383,  &piscadasConfiguradas, nullptr,      nullptr},
+  {nomeLed,            hashNomeConstante("led"),                 PARAMETRO_BOOLEANO, false,   true,  3,   0,      1,      nullptr,               lerEstadoLed, escreverEstadoLed},
+  {nomePiscarAtivo,    hashNomeConstante("piscarAtivo"),         PARAMETRO_BOOLEANO, true,    true,  5,   0,      1,      &piscarAtivo,          nullptr,      nullptr},
+  {nomeTransicoes,     hashNomeConstante("transicoesRestantes"), PARAMETRO_INTEIRO,  true,    true,  6,   -1,     32766,  &numPiscadasRestantes, nullptr,      nullptr},
+};
+static const uint8_t totalParametros = sizeof(tabelaParametros) / sizeof(tabelaParametros[0]);
+
+static_assert(sizeof(tabelaParametros) / sizeof(tabelaParametros[0]) == GC_NUM_PARAMETROS,
+              "GC_NUM_PARAMETROS (parametros.h) deve ser igual ao número de linhas de tabelaParametros");
+// Com ao menos uma posição vazia no índice, toda busca termina (e a construção sempre encontra uma posição livre).
+static_assert(GC_NUM_PARAMETROS < GC_POSICOES_HASH_PARAMETROS,
+              "GC_POSICOES_HASH_PARAMETROS deve ser maior que o número de parâmetros");
+
+// Índice de hash dos nomes: cada posição guarda o índice de um parâmetro (0xFF = vazia).
+// Construído na primeira busca; colisões são resolvidas pela próxima posição livre.
+static uint8_t indiceHash[GC_POSICOES_HASH_PARAMETROS];
+static bool indiceHashConstruido = false;
+
+static void construirIndiceHash() {
+  memset(indiceHash, 0xFF, sizeof(indiceHash));
+  for (uint8_t i = 0; i < totalParametros; i++) {
+    uint8_t posicao = descricaoParametro(i).hash % GC_POSICOES_HASH_PARAMETROS;
+    while (indiceHash[posicao] != 0xFF) posicao = (posicao + 1) % GC_POSICOES_HASH_PARAMETROS;
+    indiceHash[posicao] = i;
+  }
+  indiceHashConstruido = true;
+}
+
+uint8_t numParametros() {
+  return totalParametros;
+}
+
+ParametroInfo descricaoParametro(uint8_t indice) {
+  ParametroInfo parametro;
+  memcpy_P(&parametro, &tabelaParametros[indice], sizeof(parametro));
+  return parametro;
+}
+
+int buscarParametro(const char* nome) {
+  if (!indiceHashConstruido) construirIndiceHash();
+  uint16_t hash = hashNome(nome);
+  uint8_t posicao = hash % GC_POSICOES_HASH_PARAMETROS;
+  // Em geral a primeira posição já é a do parâmetro; o nome completo só é comparado quando o hash coincide.
+  for (uint8_t tentativas = 0; tentativas < GC_POSICOES_HASH_PARAMETROS && indiceHash[posicao] != 0xFF; tentativas++) {
+    ParametroInfo parametro = descricaoParametro(indiceHash[posicao]);
+    if (parametro.hash == hash && strcmp_P(nome, parametro.nome) == 0) return indiceHash[posicao];
+    posicao = (posicao + 1) % GC_POSICOES_HASH_PARAMETROS;
+  }
+  return -1;
+}
+
+int parametroPorRegistrador(uint16_t registrador) {
+  for (uint8_t i = 0; i < totalParametros; i++) {
+    if (descricaoParametro(i).registrador == registrador) return i;
+  }
+  return -1;
+}
+
+int lerParametro(uint8_t indice) {
+  ParametroInfo parametro = descricaoParametro(indice);
+  if (parametro.ler != nullptr) return parametro.ler();
+  if (parametro.tipo == PARAMETRO_BOOLEANO) return *(bool*)parametro.variavel ? 1 : 0;
+  return *(int*)parametro.variavel;
+}
+
+ResultadoParametro validarParametro(uint8_t indice, int valor) {
+  ParametroInfo parametro = descricaoParametro(indice);
+  if (parametro.somenteLeitura) return PARAMETRO_SOMENTE_LEITURA;
+  if (valor < parametro.minimo || valor > parametro.maximo) return PARAMETRO_FORA_DA_FAIXA;
+  return PARAMETRO_OK;
+}
+
+void escreverParametro(uint8_t indice, int valor) {
+  ParametroInfo parametro = descricaoParametro(indice);
+  if (parametro.variavel != nullptr) {
+    if (parametro.tipo == PARAMETRO_BOOLEANO) {
+      *(bool*)parametro.variavel = valor != 0;
+    } else {
+      *(int*)parametro.variavel = valor;
+    }
+  }
+  if (parametro.aoEscrever != nullptr) parametro.aoEscrever(valor);
+}
+
+void alterarParametro(uint8_t indice, int valor) {
+  escreverParametro(indice, valor);
+  registrarAlteracao(indice); // Gravada na EEPROM em segundo plano.
+  notificarParametro(indice);
+}
+
+void imprimirNomeParametro(Print& saida, uint8_t indice) {
+  ParametroInfo parametro = descricaoParametro(indice);
+  saida.print((const __FlashStringHelper*)parametro.nome);
+}
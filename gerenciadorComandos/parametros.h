@@ -0,0 +1,98 @@
+/*
+ * parametros.h
+ *
+ * Descrição:
+ * Registro de parâmetros do gerenciador de comandos. Cada parâmetro configurável
+ * (tempos do piscar, número de piscadas, estado do LED, ...) é descrito uma única vez
+ * em uma tabela na memória flash, com nome, tipo, faixa de valores e endereço de
+ * registrador Modbus.
+ *
+ * Funcionalidade Principal:
+ * A partir da tabela, os comandos genéricos "ler", "definir" e "parametros" dão
+ * acesso a todos os parâmetros, sem um handler específico para cada um, e a
+ * interface Modbus (modbusRTU.h) monta o seu mapa de registradores.
+ * A busca pelo nome usa um índice de hash (hashNome), com custo constante.
+ *
+ * Utilização:
+ * 1. Declare a variável do parâmetro (ou as funções de leitura/escrita).
+ * 2. Acrescente uma linha em 'tabelaParametros' no arquivo parametros.cpp.
+ * 3. Atualize GC_NUM_PARAMETROS (a compilação falha se o número não conferir com a tabela).
+ *
+ * Exemplo de Comando:
+ * "definir tempoLigado 250" (altera o tempo ligado do piscar para 250ms)
+ * "parametros" (lista todos os parâmetros em uma única linha)
+ */
+
+#ifndef PARAMETROS_H
+#define PARAMETROS_H
+
+#include <Arduino.h>
+
+// Número de linhas de 'tabelaParametros' (parametros.cpp), conferido na compilação.
+// Dimensiona os valores gravados pela configuração e as alterações pendentes do diário.
+#define GC_NUM_PARAMETROS 6
+
+// Número de posições do índice de hash dos nomes (deve ser maior que o número de parâmetros).
+#ifndef GC_POSICOES_HASH_PARAMETROS
+#define GC_POSICOES_HASH_PARAMETROS 16
+#endif
+
+// Tipos de parâmetro.
+enum TipoParametro {
+    PARAMETRO_INTEIRO,   // int (a variável aponta para um int).
+    PARAMETRO_BOOLEANO   // bool (a variável aponta para um bool; aceita 0 ou 1).
+};
+
+// Resultado da validação de uma escrita.
+enum ResultadoParametro {
+    PARAMETRO_OK,
+    PARAMETRO_SOMENTE_LEITURA,
+    PARAMETRO_FORA_DA_FAIXA
+};
+
+// Descrição de um parâmetro (guardada na memória flash).
+struct ParametroInfo {
+    const char* nome;            // Nome do parâmetro (string na memória flash). Ex: "tempoLigado".
+    uint16_t hash;               // hashNome(nome), calculado na compilação.
+    uint8_t tipo;                // TipoParametro.
+    bool somenteLeitura;         // Se a escrita deve ser recusada.
+    bool persistente;            // Se o valor é guardado pelo comando "salvar" (configuracao.h).
+    uint16_t registrador;        // Endereço do registrador Modbus.
+    int minimo;                  // Menor valor aceito na escrita.
+    int maximo;                  // Maior valor aceito na escrita.
+    void* variavel;              // Variável lida e escrita diretamente (nullptr se o valor for calculado).
+    int (*ler)();                // Leitura calculada (nullptr = lê 'variavel').
+    void (*aoEscrever)(int valor); // Ação executada após a escrita (nullptr = apenas grava 'variavel').
+};
+
+// Número de piscadas usado quando o piscar é disparado sem argumentos pela interface Modbus (0 = sem fim).
+extern int piscadasConfiguradas;
+
+// Número de parâmetros registrados.
+uint8_t numParametros();
+
+// Procura um parâmetro pelo nome. Retorna o índice ou -1 se não existir.
+int buscarParametro(const char* nome);
+
+// Procura um parâmetro pelo endereço de registrador Modbus. Retorna o índice ou -1 se não existir.
+int parametroPorRegistrador(uint16_t registrador);
+
+// Copia a descrição de um parâmetro da memória flash.
+ParametroInfo descricaoParametro(uint8_t indice);
+
+// Valor atual do parâmetro.
+int lerParametro(uint8_t indice);
+
+// Verifica se o valor pode ser escrito no parâmetro (tipo, faixa e permissão).
+ResultadoParametro validarParametro(uint8_t indice, int valor);
+
+// Escreve o valor (já validado) e executa a ação associada ao parâmetro.
+void escreverParametro(uint8_t indice, int valor);
+// Escreve o valor (já validado) alterado por um usuário ("definir" ou Modbus):
+// além de escreverParametro, grava a alteração no diário da EEPROM e gera o evento "parametro".
+void alterarParametro(uint8_t indice, int valor);
+
+// Imprime o nome do parâmetro (lido da memória flash).
+void imprimirNomeParametro(Print& saida, uint8_t indice);
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * portas.cpp
+ *
+ * Descrição:
+ * Operações por máscara de bits sobre vários pinos. Veja portas.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include <errno.h>
+#include "gerenciadorComandos.h"
+#include "padrao.h"
+#include "brilho.h"
+#include "portas.h"
+
+static const uint8_t pinosPortas[] = { GC_PINOS_PORTAS };
+static const uint8_t NUM_PINOS_PORTAS = sizeof(pinosPortas) / sizeof(pinosPortas[0]);
+static_assert(NUM_PINOS_PORTAS <= 32, "GC_PINOS_PORTAS deve ter no máximo 32 pinos (um bit da máscara por pino)");
+static const uint32_t MASCARA_PORTAS = NUM_PINOS_PORTAS == 32 ? 0xFFFFFFFFUL : (1UL << NUM_PINOS_PORTAS) - 1;
+
+// Os pinos da máscara passam a ser controlados pelo comando: encerra os padrões, o brilho e o piscarLed neles.
+static void assumirPinos(uint32_t mascara) {
+  for (uint8_t i = 0; i < NUM_PINOS_PORTAS; i++) {
+    if (!(mascara & (1UL << i))) continue;
+    if (pinosPortas[i] == ledPin) piscarAtivo = false;
+    pararPadrao(pinosPortas[i]);
+    pararBrilho(pinosPortas[i]);
+  }
+}
+
+#if defined(__AVR__)
+// Registradores de uma porta do microcontrolador usada pela tabela.
+struct PortaPinos {
+  volatile uint8_t* saida;    // PORTx
+  volatile uint8_t* entrada;  // PINx
+  volatile uint8_t* direcao;  // DDRx
+};
+
+static PortaPinos portas[NUM_PINOS_PORTAS]; // No pior caso, cada pino em uma porta diferente.
+static uint8_t numPortas = 0;               // 0 = tabela ainda não agrupada.
+static uint8_t portaDoPino[NUM_PINOS_PORTAS]; // Índice em 'portas' de cada pino da tabela.
+static uint8_t bitDoPino[NUM_PINOS_PORTAS];   // Bit do pino no registrador da porta.
+
+// Agrupa os pinos da tabela por porta (as tabelas do núcleo Arduino ficam na flash e são lidas aqui, uma única vez).
+static void agruparPortas() {
+  if (numPortas > 0) return;
+  for (uint8_t i = 0; i < NUM_PINOS_PORTAS; i++) {
+    uint8_t porta = digitalPinToPort(pinosPortas[i]);
+    volatile uint8_t* saida = portOutputRegister(porta);
+    uint8_t p = 0;
+    while (p < numPortas && portas[p].saida != saida) p++;
+    if (p == numPortas) { // Primeira vez que a porta aparece.
+      portas[p].saida = saida;
+      portas[p].entrada = portInputRegister(porta);
+      portas[p].direcao = portModeRegister(porta);
+      numPortas++;
+    }
+    portaDoPino[i] = p;
+    bitDoPino[i] = digitalPinToBitMask(pinosPortas[i]);
+  }
+}
+
+// Converte a máscara lógica nos bits de cada porta.
+static void mascararPortas(uint32_t mascara, uint32_t valor, uint8_t* alterar, uint8_t* ligar) {
+  agruparPortas();
+  memset(alterar, 0, numPortas);
+  memset(ligar, 0, numPortas);
+  for (uint8_t i = 0; i < NUM_PINOS_PORTAS; i++) {
+    if (!(mascara & (1UL << i))) continue;
+    alterar[portaDoPino[i]] |= bitDoPino[i];
+    if (valor & (1UL << i)) ligar[portaDoPino[i]] |= bitDoPino[i];
+  }
+}
+
+void escreverPortas(uint32_t mascara, uint32_t valor) {
+  assumirPinos(mascara);
+  uint8_t alterar[NUM_PINOS_PORTAS], ligar[NUM_PINOS_PORTAS];
+  mascararPortas(mascara, valor, alterar, ligar);
+  for (uint8_t p = 0; p < numPortas; p++) {
+    if (alterar[p] == 0) continue;
+    uint8_t sreg = SREG;
+    noInterrupts(); // Leitura-modificação-escrita: uma interrupção no meio perderia as suas alterações na porta.
+    *portas[p].saida = (*portas[p].saida & ~alterar[p]) | ligar[p];
+    *portas[p].direcao |= alterar[p]; // Depois do valor: o pino já começa a saída no nível pedido.
+    SREG = sreg;
+  }
+}
+
+void alternarPortas(uint32_t mascara) {
+  assumirPinos(mascara);
+  uint8_t alterar[NUM_PINOS_PORTAS], ligar[NUM_PINOS_PORTAS];
+  mascararPortas(mascara, 0, alterar, ligar);
+  for (uint8_t p = 0; p < numPortas; p++) {
+    if (alterar[p] == 0) continue;
+    uint8_t sreg = SREG;
+    noInterrupts();
+    *portas[p].saida ^= alterar[p];
+    *portas[p].direcao |= alterar[p];
+    SREG = sreg;
+  }
+}
+
+uint32_t lerPortas() {
+  agruparPortas();
+  uint8_t estado[NUM_PINOS_PORTAS];
+  for (uint8_t p = 0; p < numPortas; p++) estado[p] = *portas[p].entrada; // Uma leitura por porta.
+  uint32_t valor = 0;
+  for (uint8_t i = 0; i < NUM_PINOS_PORTAS; i++) {
+    if (estado[portaDoPino[i]] & bitDoPino[i]) valor |= 1UL << i;
+  }
+  return valor;
+}
+#else
+// Sem acesso direto aos registradores: um digitalWrite por pino (as mudanças não são simultâneas).
+void escreverPortas(uint32_t mascara, uint32_t valor) {
+  assumirPinos(mascara);
+  for (uint8_t i = 0; i < NUM_PINOS_PORTAS; i++) {
+    if (!(mascara & (1UL << i))) continue;
+    digitalWrite(pinosPortas[i], (valor & (1UL << i)) ? HIGH : LOW);
+    pinMode(pinosPortas[i], OUTPUT);
+  }
+}
+
+void alternarPortas(uint32_t mascara) {
+  uint32_t estado = lerPortas();
+  escreverPortas(mascara, ~estado);
+}
+
+uint32_t lerPortas() {
+  uint32_t valor = 0;
+  for (uint8_t i = 0; i < NUM_PINOS_PORTAS; i++) {
+    if (digitalRead(pinosPortas[i]) == HIGH) valor |= 1UL << i;
+  }
+  return valor;
+}
+#endif
+
+// Converte uma máscara do comando (decimal, hexadecimal com "0x" ou binária com "0b"). Retorna false se for inválida.
+// A base é escolhida apenas pelo prefixo: "010" vale 10 (com a base 0 do strtoul seria octal).
+static bool lerMascara(const char* texto, uint32_t& mascara) {
+  const char* digitos = texto;
+  int base = 10;
+  if (texto[0] == '0' && (texto[1] == 'x' || texto[1] == 'X')) {
+    digitos = texto + 2;
+    base = 16;
+  } else if (texto[0] == '0' && (texto[1] == 'b' || texto[1] == 'B')) {
+    digitos = texto + 2;
+    base = 2;
+  }
+  // O strtoul aceitaria um segundo prefixo depois do primeiro ("0x0x5" valeria 5).
+  bool prefixoRepetido = base != 10 && digitos[0] == '0' && tolower(digitos[1]) == tolower(texto[1]);
+  char* fim;
+  errno = 0;
+  mascara = strtoul(digitos, &fim, base);
+  if (fim == digitos || *fim != '\0' || !isalnum(*digitos) || prefixoRepetido || errno == ERANGE ||
+      (mascara & ~MASCARA_PORTAS) != 0) {
+    Serial.print("Erro: Máscara inválida: ");
+    Serial.print(texto);
+    Serial.print(" (use até 0x");
+    Serial.print(MASCARA_PORTAS, HEX);
+    Serial.println(").");
+    return false;
+  }
+  return true;
+}
+
+// Trata o comando "portas".
+static void tratarPortas(Comando comando) {
+  uint32_t mascara, valor;
+  if (comando.numValores == 1 && comando.valores[0] == "ler") {
+    Serial.print("portas=0x");
+    Serial.println(lerPortas(), HEX);
+  } else if (comando.numValores == 3 && comando.valores[0] == "escrever") {
+    if (!lerMascara(comando.valores[1], mascara) || !lerMascara(comando.valores[2], valor)) return;
+    escreverPortas(mascara, valor);
+  } else if (comando.numValores == 2 && comando.valores[0] == "alternar") {
+    if (!lerMascara(comando.valores[1], mascara)) return;
+    alternarPortas(mascara);
+  } else {
+    Serial.println("Erro: Use 'portas escrever <mascara> <valor>', 'portas alternar <mascara>' ou 'portas ler'.");
+  }
+}
+REGISTRAR_COMANDO("portas", tratarPortas, "escrever <mascara> <valor> | alternar <mascara> | ler");
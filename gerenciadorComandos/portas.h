@@ -0,0 +1,43 @@
+/*
+ * portas.h
+ *
+ * Descrição:
+ * Escrita e leitura de várias saídas digitais com um único comando, por máscara de bits,
+ * com o comando "portas":
+ *     portas escrever <mascara> <valor>   Os pinos da máscara recebem o bit correspondente de 'valor'.
+ *     portas alternar <mascara>           Inverte os pinos da máscara.
+ *     portas ler                          Responde "portas=0x..." com o estado de todos os pinos da tabela.
+ * Máscara e valor podem ser decimais, hexadecimais (ex: 0x0F0F) ou binários (ex: 0b1010).
+ *
+ * Funcionalidade Principal:
+ * O bit 0 da máscara corresponde ao primeiro pino de GC_PINOS_PORTAS, o bit 1 ao segundo, e assim
+ * por diante. Nas placas AVR os pinos da tabela são agrupados pela porta do microcontrolador
+ * (PORTB, PORTD, ...) na primeira utilização, e cada comando escreve uma única vez no registrador
+ * de cada porta envolvida, com as interrupções desabilitadas: todos os pinos de uma mesma porta
+ * mudam no mesmo instante, e as interrupções que usam a mesma porta não perdem as suas alterações.
+ * Nas demais placas os pinos são escritos um a um com digitalWrite().
+ * Os pinos escritos passam a ser saídas, e deixam de ser controlados pelos padrões, pelo controle
+ * de brilho e pelo piscarLed (como quando um padrão ou um brilho assume um pino).
+ *
+ * Exemplo de Comando:
+ * "portas escrever 0x0F 0x05" (com a tabela padrão: pinos 2 e 5 ligados, 4 e 6 desligados)
+ */
+
+#ifndef PORTAS_H
+#define PORTAS_H
+
+#include <Arduino.h>
+
+// Pinos controlados pelo comando "portas", na ordem dos bits da máscara (no máximo 32).
+// Padrão: pinos digitais 2 a 12 do Arduino Uno (PORTD e PORTB), exceto 3 e 11 (Timer2, usado pelo
+// controle de brilho e por tone()). O pino 13 fica de fora por ser o LED dos comandos ligarLed, piscarLed, ...
+#ifndef GC_PINOS_PORTAS
+#define GC_PINOS_PORTAS 2, 4, 5, 6, 7, 8, 9, 10, 12
+#endif
+
+// Alteram os pinos indicados pela máscara (bit 0 = primeiro pino de GC_PINOS_PORTAS).
+void escreverPortas(uint32_t mascara, uint32_t valor);
+void alternarPortas(uint32_t mascara);
+uint32_t lerPortas(); // Estado de todos os pinos da tabela.
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * telemetria.cpp
+ *
+ * Descrição:
+ * Envio periódico do estado da placa. Veja telemetria.h para a descrição e as instruções de uso.
+ */
+
+#include <Arduino.h>
+#include "gerenciadorComandos.h"
+#include "telemetria.h"
+#include "brilho.h" // pinoLigado.
+
+enum CampoTelemetria {
+  CAMPO_LED,
+  CAMPO_PISCAR_ATIVO,
+  CAMPO_RESTANTES,
+  CAMPO_CICLOS,
+  CAMPO_MAIOR_INTERVALO,
+  NUM_CAMPOS_TELEMETRIA
+};
+static const char letrasCampos[NUM_CAMPOS_TELEMETRIA] = {'l', 'a', 'r', 'c', 'm'};
+
+static unsigned long periodoTelemetria = 0;   // 0 = telemetria desativada.
+static unsigned long inicioPeriodo = 0;
+static uint16_t sequenciaTelemetria = 0;
+static uint8_t registrosDesdeChave = 0;
+static bool enviarChave = true;                // O primeiro registro é sempre completo.
+static long ultimosValores[NUM_CAMPOS_TELEMETRIA]; // Valores do último registro enviado.
+
+// Estatísticas do loop() no período atual.
+static unsigned long ciclos = 0;
+static unsigned long ultimaExecucao = 0;
+static unsigned long maiorIntervalo = 0;
+
+static void lerCampos(long* valores) {
+  valores[CAMPO_LED] = pinoLigado(ledPin); // Sem amostrar a modulação do brilho.
+  valores[CAMPO_PISCAR_ATIVO] = piscarAtivo;
+  valores[CAMPO_RESTANTES] = numPiscadasRestantes;
+  valores[CAMPO_CICLOS] = ciclos;
+  valores[CAMPO_MAIOR_INTERVALO] = maiorIntervalo;
+}
+
+void atualizarTelemetria(bool podeEnviar) {
+  if (periodoTelemetria == 0) return;
+
+  unsigned long agora = millis();
+  ciclos++;
+  if (agora - ultimaExecucao > maiorIntervalo) maiorIntervalo = agora - ultimaExecucao;
+  ultimaExecucao = agora;
+
+  if (agora - inicioPeriodo < periodoTelemetria) return;
+  if (!podeEnviar || Serial.availableForWrite() < GC_ESPACO_TELEMETRIA) return; // Atrasado: sai na próxima chamada.
+  inicioPeriodo = agora;
+
+  long valores[NUM_CAMPOS_TELEMETRIA];
+  lerCampos(valores);
+  bool chave = enviarChave || registrosDesdeChave >= GC_TELEMETRIA_CHAVE - 1;
+  Serial.print('%');
+  if (chave) Serial.print('K');
+  Serial.print(sequenciaTelemetria++);
+  for (uint8_t campo = 0; campo < NUM_CAMPOS_TELEMETRIA; campo++) {
+    if (!chave && valores[campo] == ultimosValores[campo]) continue; // Delta: apenas os campos que mudaram.
+    Serial.print(' ');
+    Serial.print(letrasCampos[campo]);
+    Serial.print(valores[campo]);
+    ultimosValores[campo] = valores[campo];
+  }
+  Serial.println();
+  registrosDesdeChave = chave ? 0 : registrosDesdeChave + 1;
+  enviarChave = false;
+
+  ciclos = 0; // As estatísticas do loop() recomeçam a cada registro.
+  maiorIntervalo = 0;
+}
+
+// Trata o comando "telemetria".
+static void tratarTelemetria(Comando comando) {
+  // O comando "telemetria" espera o período em milissegundos (0 encerra o envio).
+  if (comando.numValores != 1) {
+    Serial.println("Erro: O comando 'telemetria' espera 1 parâmetro: <periodo> (ms, 0 = desligar).");
+    return;
+  }
+  long periodo = comando.valores[0].toInt();
+  if (periodo != 0 && periodo < GC_TELEMETRIA_PERIODO_MINIMO) {
+    Serial.print("Erro: O período mínimo é ");
+    Serial.print(GC_TELEMETRIA_PERIODO_MINIMO);
+    Serial.println("ms.");
+    return;
+  }
+  periodoTelemetria = periodo;
+  inicioPeriodo = ultimaExecucao = millis();
+  ciclos = 0;
+  maiorIntervalo = 0;
+  enviarChave = true; // Um novo envio começa com um registro completo.
+  Serial.println(periodo != 0 ? "Telemetria ativada." : "Telemetria desativada.");
+}
+REGISTRAR_COMANDO("telemetria", tratarTelemetria, "<periodo>");
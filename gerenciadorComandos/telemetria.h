@@ -0,0 +1,49 @@
+/*
+ * telemetria.h
+ *
+ * Descrição:
+ * Envio periódico do estado da placa para painéis no computador, com o comando
+ * "telemetria <periodo>" (em milissegundos; 0 encerra o envio).
+ *
+ * Funcionalidade Principal:
+ * A cada período é enviado um registro compacto em texto, com apenas os campos que
+ * mudaram desde o registro anterior (codificação delta). A cada GC_TELEMETRIA_CHAVE
+ * registros é enviado um registro completo (chave), para que um painel que começou a
+ * ouvir no meio do envio (ou que perdeu uma linha) recupere o estado inteiro.
+ *
+ *   Registro completo: "%K<seq> l1 a1 r6 c4871 m2"
+ *   Registro delta:    "%<seq> r5 c4903"   (ou apenas "%<seq>", se nada mudou)
+ *
+ * Campos: l = LED (0/1), a = piscar ativo (0/1), r = transições restantes do piscar,
+ *         c = execuções do loop() no período, m = maior intervalo entre duas execuções do loop() (ms).
+ * A sequência (0 a 65535) permite ao painel detectar registros perdidos: após uma falha,
+ * os deltas só devem ser aplicados a partir do próximo registro completo.
+ *
+ * Os registros só são enviados quando há espaço no buffer de transmissão (um registro
+ * atrasado apenas sai na próxima chamada) e, como os eventos (eventos.h), apenas sem
+ * endereço RS-485 configurado.
+ */
+
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <Arduino.h>
+
+// Um registro completo a cada GC_TELEMETRIA_CHAVE registros.
+#ifndef GC_TELEMETRIA_CHAVE
+#define GC_TELEMETRIA_CHAVE 10
+#endif
+// Menor período aceito pelo comando "telemetria" (em milissegundos).
+#ifndef GC_TELEMETRIA_PERIODO_MINIMO
+#define GC_TELEMETRIA_PERIODO_MINIMO 20
+#endif
+// Espaço livre mínimo no buffer de transmissão para enviar um registro sem bloquear.
+#ifndef GC_ESPACO_TELEMETRIA
+#define GC_ESPACO_TELEMETRIA 40
+#endif
+
+// Mede o loop() e, se a telemetria estiver ativa, envia o registro do período.
+// Chamada por gerenciadorComando::atualizar() a cada loop(); 'podeEnviar' é falso no meio de uma linha.
+void atualizarTelemetria(bool podeEnviar);
+
+#endif
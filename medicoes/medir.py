@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+medir.py
+
+Compila, carrega e executa um sketch de medição (medicoes/*) com várias configurações,
+e reúne os resultados em um arquivo CSV.
+
+Cada configuração é uma lista de macros passadas ao compilador (-D). Para cada uma,
+o script compila o sketch com o arduino-cli (usando a biblioteca deste repositório),
+guarda o tamanho do programa informado pelo arduino-cli, carrega o programa na placa
+e lê a Serial até a linha "Fim das medicoes.". Cada linha impressa no formato
+"<nome>: menor <x>us, media <y>us" vira uma linha do CSV.
+
+Requisitos: arduino-cli (com o núcleo da placa instalado) e pyserial.
+
+Exemplo:
+  python3 medicoes/medir.py --placa arduino:avr:uno --porta /dev/ttyACM0 \\
+      --sketch medicoes/medirRecepcao --config "" --config "GC_BUSCA=1" \\
+      --config "GC_CHECKSUM=0" --saida recepcao.csv
+"""
+
+import argparse
+import csv
+import os
+import re
+import subprocess
+import sys
+import time
+
+RAIZ = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BIBLIOTECA = os.path.join(RAIZ, "gerenciadorComandos")
+
+LINHA_MEDICAO = re.compile(r"^(.*): menor ([0-9.]+)us, media ([0-9.]+)us$")
+TAMANHO_PROGRAMA = re.compile(r"(?:Sketch uses|O sketch usa) ([0-9]+) bytes")
+
+
+def compilar(sketch, placa, macros, pasta_build):
+    """Compila o sketch e devolve o tamanho do programa (bytes de flash)."""
+    opcoes = " ".join("-D" + macro for macro in macros)
+    comando = ["arduino-cli", "compile", "-b", placa, "--library", BIBLIOTECA,
+               "--build-path", pasta_build,
+               "--build-property", "build.extra_flags=" + opcoes, sketch]
+    resultado = subprocess.run(comando, capture_output=True, text=True)
+    if resultado.returncode != 0:
+        sys.stderr.write(resultado.stdout + resultado.stderr)
+        raise RuntimeError("falha ao compilar com: " + (opcoes or "(padrão)"))
+    tamanho = TAMANHO_PROGRAMA.search(resultado.stdout)
+    return int(tamanho.group(1)) if tamanho else None
+
+
+def carregar(sketch, placa, porta, pasta_build):
+    comando = ["arduino-cli", "upload", "-b", placa, "-p", porta,
+               "--input-dir", pasta_build, sketch]
+    subprocess.run(comando, check=True, capture_output=True)
+
+
+def ler_medicoes(porta, velocidade, limite_s):
+    """Lê a Serial até "Fim das medicoes." e devolve as linhas impressas."""
+    import serial  # pyserial
+    linhas = []
+    with serial.Serial(porta, velocidade, timeout=1) as conexao:
+        fim = time.time() + limite_s
+        while time.time() < fim:
+            linha = conexao.readline().decode("ascii", "replace").strip()
+            if not linha:
+                continue
+            print("  " + linha)
+            if linha == "Fim das medicoes.":
+                return linhas
+            linhas.append(linha)
+    raise RuntimeError("a placa não terminou as medições em %ds" % limite_s)
+
+
+def medir(sketch, placa, porta, configuracoes, velocidade=115200, limite_s=120):
+    """Devolve uma lista de dicionários (uma linha do CSV por medição)."""
+    resultados = []
+    pasta_build = os.path.join(RAIZ, "medicoes", ".build")
+    for config in configuracoes:
+        macros = config.split()
+        print("Configuração: " + (config or "(padrão)"))
+        tamanho = compilar(sketch, placa, macros, pasta_build)
+        carregar(sketch, placa, porta, pasta_build)
+        time.sleep(2)  # A placa reinicia ao abrir a porta.
+        for linha in ler_medicoes(porta, velocidade, limite_s):
+            medicao = LINHA_MEDICAO.match(linha)
+            if medicao:
+                resultados.append({"configuracao": config, "flash": tamanho,
+                                   "medicao": medicao.group(1),
+                                   "menor_us": float(medicao.group(2)),
+                                   "media_us": float(medicao.group(3))})
+    return resultados
+
+
+def gravar_csv(resultados, arquivo):
+    campos = ["configuracao", "flash", "medicao", "menor_us", "media_us"]
+    for resultado in resultados:
+        for campo in resultado:
+            if campo not in campos:
+                campos.append(campo)
+    with open(arquivo, "w", newline="") as saida:
+        escritor = csv.DictWriter(saida, fieldnames=campos)
+        escritor.writeheader()
+        escritor.writerows(resultados)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--placa", required=True, help="FQBN, ex: arduino:avr:uno")
+    parser.add_argument("--porta", required=True, help="porta serial, ex: /dev/ttyACM0")
+    parser.add_argument("--sketch", default=os.path.join(RAIZ, "medicoes", "medirRecepcao"))
+    parser.add_argument("--config", action="append",
+                        help='macros separadas por espaço, ex: "GC_BUSCA=1 GC_CHECKSUM=0" '
+                             '(pode ser repetido; "" = padrão)')
+    parser.add_argument("--saida", default="medicoes.csv")
+    args = parser.parse_args()
+
+    resultados = medir(args.sketch, args.placa, args.porta, args.config or [""])
+    gravar_csv(resultados, args.saida)
+    print("%d medições gravadas em %s" % (len(resultados), args.saida))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,13 @@
+// Gerado por gerar.py: 5 comandos para medirBusca.ino. Não edite.
+#define NUM_COMANDOS_GERADOS 5
+
+static void tratarGerado0(Comando) { execucoes++; }
+REGISTRAR_COMANDO("xazjl0", tratarGerado0, "");
+static void tratarGerado1(Comando) { execucoes++; }
+REGISTRAR_COMANDO("isn1", tratarGerado1, "");
+static void tratarGerado2(Comando) { execucoes++; }
+REGISTRAR_COMANDO("ldn2", tratarGerado2, "");
+static void tratarGerado3(Comando) { execucoes++; }
+REGISTRAR_COMANDO("ruft3", tratarGerado3, "");
+static void tratarGerado4(Comando) { execucoes++; }
+REGISTRAR_COMANDO("flxxcq4", tratarGerado4, "");
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+"""
+gerar.py
+
+Gera medicoes/medirBusca/comandosGerados.h com N comandos registrados por REGISTRAR_COMANDO,
+para medir a busca de nomes (GC_BUSCA) com tabelas de tamanhos diferentes.
+
+Os nomes têm de 3 a 12 caracteres, letras minúsculas sorteadas (sempre com a mesma semente,
+para que as medições sejam reproduzíveis) seguidas do número do comando. O número garante
+nomes diferentes entre si e dos comandos da biblioteca (que não têm algarismos), e é assim
+que o sketch reconhece os comandos gerados.
+
+Uso: python3 medicoes/medirBusca/gerar.py N
+"""
+
+import os
+import random
+import sys
+
+ARQUIVO = os.path.join(os.path.dirname(os.path.abspath(__file__)), "comandosGerados.h")
+
+
+def gerar_nomes(n):
+    sorteio = random.Random(12345)
+    letras = "abcdefghijklmnopqrstuvwxyz"
+    nomes = []
+    for i in range(n):
+        tamanho = sorteio.randint(2, 8)
+        nomes.append("".join(sorteio.choice(letras) for _ in range(tamanho)) + str(i))
+    return nomes
+
+
+def gerar(n, arquivo=ARQUIVO):
+    linhas = [
+        "// Gerado por gerar.py: %d comandos para medirBusca.ino. Não edite." % n,
+        "#define NUM_COMANDOS_GERADOS %d" % n,
+        "",
+    ]
+    for i, nome in enumerate(gerar_nomes(n)):
+        linhas.append("static void tratarGerado%d(Comando) { execucoes++; }" % i)
+        linhas.append('REGISTRAR_COMANDO("%s", tratarGerado%d, "");' % (nome, i))
+    with open(arquivo, "w") as saida:
+        saida.write("\n".join(linhas) + "\n")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("Uso: gerar.py N")
+    gerar(int(sys.argv[1]))
@@ -0,0 +1,159 @@
+/*
+ * medirBusca.ino
+ *
+ * Descrição:
+ * Medição do custo da busca do nome do comando (GC_BUSCA) em função do número de comandos.
+ * Os comandos são gerados por gerar.py (comandosGerados.h, N comandos registrados por
+ * REGISTRAR_COMANDO), e o sketch imprime o tempo de reconhecimento de uma linha.
+ *
+ * Funcionalidade Principal:
+ * Para até AMOSTRAS_NOMES comandos gerados (espalhados pelo registro), a linha com o nome é
+ * entregue ao gerenciador byte a byte, REPETICOES_NOME vezes, e é medido o tempo do primeiro
+ * byte até o retorno do '\n' (a busca de GC_BUSCA_PREFIXO é feita durante a recepção; as demais,
+ * no fim do nome). Também é medido um nome inexistente, que percorre a busca inteira.
+ * São informados o menor tempo e a média, em microssegundos.
+ *
+ * Nas placas AVR o tempo é contado pelo Timer1 com prescaler 8 (0,5us a 16MHz, até 32ms por
+ * linha); nas demais placas, por micros().
+ *
+ * Cada comando registrado ocupa RAM nas placas AVR (ComandoInfo, nome e o índice ordenado):
+ * no Arduino Uno cabem algumas dezenas de comandos gerados, no Mega algumas centenas.
+ * Para a varredura até 5000 comandos, use uma placa de 32 bits (ex: ESP32).
+ *
+ * Utilização:
+ * 1. Gere os comandos: python3 medicoes/medirBusca/gerar.py 100
+ * 2. Compile com a mesma GC_MAX_COMANDOS para a biblioteca e o sketch (mais que N e os comandos da
+ *    biblioteca), por exemplo:
+ *      arduino-cli compile -b esp32:esp32:esp32 --library gerenciadorComandos \
+ *        --build-property "build.extra_flags=-DGC_BUSCA=4 -DGC_MAX_COMANDOS=132" medicoes/medirBusca
+ * 3. Carregue, e abra o Monitor Serial a 115200 bauds.
+ * Ou use medirBusca.py, que gera, compila e mede todas as combinações de GC_BUSCA e tamanho, e
+ * grava também o tamanho do programa de cada uma.
+ */
+
+#include <gerenciadorComandos.h>
+
+const int ledPin = 13; // Exigido pela biblioteca (LED dos comandos ligarLed, piscarLed, ...).
+
+gerenciadorComando gerenciador;
+
+static const unsigned int AMOSTRAS_NOMES = 50; // Nomes medidos (no máximo).
+static const int REPETICOES_NOME = 10;         // Medições de cada nome.
+
+// Cronômetro: Timer1 com prescaler 8 nas placas AVR; micros() nas demais.
+#if defined(__AVR__)
+typedef uint16_t Tiques;
+static const float TIQUES_POR_US = F_CPU / 8000000.0;
+static void iniciarCronometro() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11); // Prescaler 8.
+  TIMSK1 = 0;
+}
+static inline Tiques tiques() { return TCNT1; }
+#else
+typedef unsigned long Tiques;
+static const float TIQUES_POR_US = 1.0;
+static void iniciarCronometro() {}
+static inline Tiques tiques() { return micros(); }
+#endif
+
+static volatile unsigned int execucoes; // Contado pelos comandos gerados: confirma que a linha foi reconhecida.
+
+#include "comandosGerados.h"
+
+// Resultado de uma série de medições.
+struct Medicao {
+  unsigned long menor;
+  unsigned long soma;
+  unsigned int amostras;
+
+  void limpar() {
+    menor = 0xFFFFFFFFUL;
+    soma = 0;
+    amostras = 0;
+  }
+  void registrar(Tiques inicio, Tiques fim) {
+    unsigned long tempo = (Tiques)(fim - inicio); // A subtração no tipo do contador tolera a volta.
+    if (tempo < menor) menor = tempo;
+    soma += tempo;
+    amostras++;
+  }
+};
+
+static void imprimirMedicao(const char* nome, const Medicao& medicao) {
+  Serial.print(nome);
+  Serial.print(": menor ");
+  Serial.print(medicao.menor / TIQUES_POR_US, 2);
+  Serial.print("us, media ");
+  Serial.print(medicao.soma / TIQUES_POR_US / medicao.amostras, 2);
+  Serial.println("us");
+}
+
+// Entrega a linha byte a byte e mede do primeiro byte até o retorno do '\n'.
+static void medirLinha(const char* nome, Medicao& medicao) {
+  Tiques inicio = tiques();
+  for (const char* c = nome; *c != '\0'; c++) gerenciador.receberByte(*c);
+  gerenciador.receberByte('\n');
+  medicao.registrar(inicio, tiques());
+}
+
+// Os comandos gerados são os únicos cujo nome termina com um algarismo.
+static bool comandoGerado(const char* nome) {
+  size_t comprimento = strlen(nome);
+  return comprimento > 0 && isdigit(nome[comprimento - 1]);
+}
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(ledPin, OUTPUT);
+  iniciarCronometro();
+  Serial.print("Configuracao: GC_BUSCA=");
+  Serial.print(GC_BUSCA);
+  Serial.print(" GC_MAX_COMANDOS=");
+  Serial.print(GC_MAX_COMANDOS);
+  Serial.print(" comandos gerados=");
+  Serial.println(NUM_COMANDOS_GERADOS);
+
+  // Nomes gerados espalhados pelo registro (a ordem do registro não é a ordem alfabética).
+  IndiceComando total = numComandosRegistrados();
+  for (IndiceComando i = 0; i < total; i++) { // Uma linha fora da medição: o índice é construído na primeira linha.
+    const char* nome = comandoRegistrado(i)->nome;
+    if (!comandoGerado(nome)) continue;
+    for (const char* c = nome; *c != '\0'; c++) gerenciador.receberByte(*c);
+    gerenciador.receberByte('\n');
+    break;
+  }
+  unsigned int passo = NUM_COMANDOS_GERADOS > AMOSTRAS_NOMES ? NUM_COMANDOS_GERADOS / AMOSTRAS_NOMES : 1;
+  Medicao acerto;
+  acerto.limpar();
+  unsigned int gerados = 0;
+  unsigned int esperadas = 0;
+  execucoes = 0;
+  for (IndiceComando i = 0; i < total; i++) {
+    const char* nome = comandoRegistrado(i)->nome;
+    if (!comandoGerado(nome) || gerados++ % passo != 0) continue;
+    for (int j = 0; j < REPETICOES_NOME; j++) medirLinha(nome, acerto);
+    esperadas += REPETICOES_NOME;
+  }
+  if (execucoes != esperadas) {
+    Serial.println("Erro: nem todos os comandos gerados foram reconhecidos (GC_MAX_COMANDOS pequeno?).");
+  }
+  imprimirMedicao("nome existente", acerto);
+
+  // Nome inexistente, depois de todos os nomes na ordem alfabética. As primeiras linhas inválidas levam o
+  // gerenciador à ressincronização, em que as mensagens de erro deixam de ser enviadas (e de ser medidas).
+  const char* inexistente = "zzzzzzzz";
+  for (int j = 0; j < GC_ERROS_PARA_RESSINCRONIZAR; j++) {
+    for (const char* c = inexistente; *c != '\0'; c++) gerenciador.receberByte(*c);
+    gerenciador.receberByte('\n');
+  }
+  Serial.flush();
+  Medicao falha;
+  falha.limpar();
+  for (int j = 0; j < REPETICOES_NOME; j++) medirLinha(inexistente, falha);
+  imprimirMedicao("nome inexistente", falha);
+  Serial.println("Fim das medicoes.");
+}
+
+void loop() {
+}
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+medirBusca.py
+
+Varredura do custo da busca de nomes: para cada número de comandos (gerar.py) e cada forma de
+busca (GC_BUSCA), compila, carrega e executa medirBusca.ino, e grava em um CSV o tamanho do
+programa e os tempos de busca (nome existente e inexistente). Com --grafico, desenha também
+os tempos e o tamanho em função do número de comandos (requer matplotlib).
+
+As combinações que não cabem na placa (erro de compilação, em geral falta de RAM nas placas
+AVR) são informadas e ficam fora do CSV.
+
+Requisitos: os mesmos de medicoes/medir.py (arduino-cli e pyserial).
+
+Exemplo:
+  python3 medicoes/medirBusca/medirBusca.py --placa esp32:esp32:esp32 --porta /dev/ttyUSB0 \\
+      --saida busca.csv --grafico busca.png
+"""
+
+import argparse
+import os
+import sys
+
+PASTA = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.dirname(PASTA))
+
+import medir  # medicoes/medir.py
+import gerar  # medicoes/medirBusca/gerar.py
+
+BUSCAS = {0: "prefixo", 1: "linear", 2: "binaria", 3: "inicial", 4: "hash"}
+TAMANHOS = [5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000]
+COMANDOS_BIBLIOTECA = 32  # Folga para os comandos da tabela principal e dos módulos.
+
+
+def varrer(placa, porta, tamanhos, buscas):
+    resultados = []
+    for n in tamanhos:
+        gerar.gerar(n)
+        for busca in buscas:
+            config = "GC_BUSCA=%d GC_MAX_COMANDOS=%d" % (busca, n + COMANDOS_BIBLIOTECA)
+            try:
+                medicoes = medir.medir(PASTA, placa, porta, [config])
+            except RuntimeError as erro:
+                print("  ignorado: %s" % erro)
+                continue
+            for medicao in medicoes:
+                medicao["comandos"] = n
+                medicao["busca"] = BUSCAS[busca]
+            resultados.extend(medicoes)
+    return resultados
+
+
+def desenhar(resultados, arquivo):
+    import matplotlib
+    matplotlib.use("Agg")
+    import matplotlib.pyplot as plt
+
+    figura, (tempo, flash) = plt.subplots(1, 2, figsize=(12, 5))
+    for busca in BUSCAS.values():
+        pontos = [r for r in resultados if r["busca"] == busca and r["medicao"] == "nome existente"]
+        if not pontos:
+            continue
+        tempo.plot([p["comandos"] for p in pontos], [p["media_us"] for p in pontos], marker="o", label=busca)
+        flash.plot([p["comandos"] for p in pontos], [p["flash"] for p in pontos], marker="o", label=busca)
+    for eixo, titulo in ((tempo, "Tempo medio da linha (us)"), (flash, "Tamanho do programa (bytes)")):
+        eixo.set_xscale("log")
+        eixo.set_xlabel("Comandos gerados")
+        eixo.set_title(titulo)
+        eixo.legend()
+        eixo.grid(True)
+    figura.tight_layout()
+    figura.savefig(arquivo)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--placa", required=True, help="FQBN, ex: esp32:esp32:esp32")
+    parser.add_argument("--porta", required=True, help="porta serial, ex: /dev/ttyUSB0")
+    parser.add_argument("--tamanhos", default=",".join(str(n) for n in TAMANHOS),
+                        help="números de comandos, separados por vírgula")
+    parser.add_argument("--buscas", default="0,1,2,3,4", help="valores de GC_BUSCA, separados por vírgula")
+    parser.add_argument("--saida", default="busca.csv")
+    parser.add_argument("--grafico", help="arquivo de imagem (opcional)")
+    args = parser.parse_args()
+
+    resultados = varrer(args.placa, args.porta,
+                        [int(n) for n in args.tamanhos.split(",")],
+                        [int(b) for b in args.buscas.split(",")])
+    medir.gravar_csv(resultados, args.saida)
+    print("%d medições gravadas em %s" % (len(resultados), args.saida))
+    if args.grafico:
+        desenhar(resultados, args.grafico)
+    gerar.gerar(5)  # Volta ao arquivo padrão do repositório.
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,235 @@
+/*
+ * medirRecepcao.ino
+ *
+ * Descrição:
+ * Medição do caminho entre a Serial e a função de tratamento de um comando.
+ * Roda na própria placa, sem nada conectado além da Serial, e imprime os tempos medidos.
+ *
+ * Funcionalidade Principal:
+ * As linhas de teste são entregues ao gerenciador byte a byte (receberByte), como se
+ * tivessem chegado pela Serial, e cada medição é repetida REPETICOES vezes.
+ * Para cada caso são informados o menor tempo e a média, em microssegundos
+ * (o menor tempo não inclui as interrupções do millis() e da Serial).
+ *
+ * - Reconhecimento: tempo entre o último byte da linha ('\n') e o início da função de
+ *   tratamento, com o reconhecimento byte a byte (receberByte) e com o reconhecimento
+ *   da linha inteira (analisarComando e processarComando, como antes do reconhecimento
+ *   byte a byte). Também é informado o custo de cada byte anterior ao '\n'.
+ * - Checksum: a mesma linha terminada por "*XX" (GC_CHECKSUM). Comparando o custo por byte com
+ *   e sem "*XX", e entre compilações com GC_CHECKSUM igual a 0 (sem verificação), 1 (XOR) e
+ *   2 (CRC-8), obtém-se o custo da verificação em cada byte e no fim da linha.
+ * - Despacho: tempo entre o '\n' e o retorno de receberByte (busca, despacho e função) para
+ *   "desligarLed", um comando simples da tabela principal. A diferença entre compilações com
+ *   GC_DESPACHO_ESTATICO igual a 1 (switch) e 0 (ponteiro de função) é o custo do despacho.
+ *   A linha "medir", registrada por REGISTRAR_COMANDO, é sempre chamada por ponteiro.
+ *   Da mesma forma, compilações com GC_ETAPAS_DESPACHO vazia (-DGC_ETAPAS_DESPACHO=) e com o
+ *   padrão (EtapaOrcamento) dão o custo das etapas em volta de cada comando.
+ *
+ * Nas placas AVR o tempo é contado pelo Timer1, em ciclos da CPU (62,5ns a 16MHz);
+ * nas demais placas, por micros().
+ *
+ * Utilização:
+ * 1. Instale a biblioteca gerenciadorComandos e carregue este sketch na placa.
+ * 2. Abra o Monitor Serial a 115200 bauds.
+ * 3. Para comparar configurações, compile com outras opções, por exemplo:
+ *      arduino-cli compile -b arduino:avr:uno --build-property "build.extra_flags=-DGC_BUSCA=1"
+ *    ou use medicoes/medir.py, que compila, carrega e reúne os resultados de várias configurações.
+ */
+
+#include <gerenciadorComandos.h>
+#include <etapasDespacho.h> // GC_ETAPAS_DESPACHO, impressa com a configuração.
+
+const int ledPin = 13; // Exigido pela biblioteca (LED dos comandos ligarLed, piscarLed, ...).
+
+gerenciadorComando gerenciador;
+
+static const int REPETICOES = 200;
+
+// Cronômetro: nas placas AVR, o Timer1 conta os ciclos da CPU (sem prescaler), e cada medição
+// deve durar menos de 65536 ciclos (4ms a 16MHz). Nas demais placas, micros().
+#if defined(__AVR__)
+typedef uint16_t Tiques;
+static const float TIQUES_POR_US = F_CPU / 1000000.0;
+static void iniciarCronometro() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10); // Sem prescaler: uma contagem por ciclo.
+  TIMSK1 = 0;
+}
+static inline Tiques tiques() { return TCNT1; }
+#else
+typedef unsigned long Tiques;
+static const float TIQUES_POR_US = 1.0;
+static void iniciarCronometro() {}
+static inline Tiques tiques() { return micros(); }
+#endif
+
+// Resultado de uma série de medições.
+struct Medicao {
+  unsigned long menor;
+  unsigned long soma;
+  unsigned int amostras;
+
+  void limpar() {
+    menor = 0xFFFFFFFFUL;
+    soma = 0;
+    amostras = 0;
+  }
+  void registrar(Tiques inicio, Tiques fim) {
+    unsigned long tempo = (Tiques)(fim - inicio); // A subtração no tipo do contador tolera a volta.
+    if (tempo < menor) menor = tempo;
+    soma += tempo;
+    amostras++;
+  }
+};
+
+static void imprimirMedicao(const char* nome, const Medicao& medicao) {
+  Serial.print(nome);
+  if (medicao.amostras == 0) {
+    Serial.println(": a funcao nao foi executada (linha recusada)");
+    return;
+  }
+  Serial.print(": menor ");
+  Serial.print(medicao.menor / TIQUES_POR_US, 2);
+  Serial.print("us, media ");
+  Serial.print(medicao.soma / TIQUES_POR_US / medicao.amostras, 2);
+  Serial.println("us");
+}
+
+// Comando usado nas medições: apenas registra o instante em que a função começou.
+static volatile Tiques inicioFuncao;
+static volatile unsigned int execucoes; // Permite descartar as linhas recusadas (ex: checksum incorreto).
+static void tratarMedir(Comando) {
+  inicioFuncao = tiques();
+  execucoes++;
+}
+REGISTRAR_COMANDO("medir", tratarMedir, "");
+
+// Entrega a linha ao gerenciador byte a byte, medindo cada byte antes do '\n' e o '\n' até a função.
+static void medirLinhaPorByte(const char* texto, Medicao& porByte, Medicao& ateFuncao) {
+  for (const char* c = texto; *c != '\0'; c++) {
+    Tiques inicio = tiques();
+    gerenciador.receberByte(*c);
+    porByte.registrar(inicio, tiques());
+  }
+  unsigned int execucoesAntes = execucoes;
+  Tiques inicio = tiques();
+  gerenciador.receberByte('\n');
+  if (execucoes != execucoesAntes) ateFuncao.registrar(inicio, inicioFuncao);
+}
+
+// Reconhecimento da linha inteira, depois de recebida: tokeniza e procura o nome na tabela.
+static void medirLinhaInteira(const String& texto, Medicao& ateFuncao) {
+  unsigned int execucoesAntes = execucoes;
+  Tiques inicio = tiques();
+  Comando comando = gerenciador.analisarComando(texto);
+  gerenciador.processarComando(comando);
+  if (execucoes != execucoesAntes) ateFuncao.registrar(inicio, inicioFuncao);
+}
+
+static void imprimirLinha(const char* texto) {
+  Serial.print("Linha: \"");
+  Serial.print(texto);
+  Serial.println("\"");
+}
+
+static const char LINHA_TESTE[] = "medir 3 500 250";
+
+static void medirReconhecimento() {
+  String textoInteiro = LINHA_TESTE;
+  Medicao porByte, ateFuncao, linhaInteira;
+  porByte.limpar();
+  ateFuncao.limpar();
+  linhaInteira.limpar();
+  for (int i = 0; i < REPETICOES; i++) {
+    medirLinhaPorByte(LINHA_TESTE, porByte, ateFuncao);
+    medirLinhaInteira(textoInteiro, linhaInteira);
+  }
+  imprimirLinha(LINHA_TESTE);
+  imprimirMedicao("byte a byte, cada byte antes do fim da linha", porByte);
+  imprimirMedicao("byte a byte, do fim da linha ate a funcao", ateFuncao);
+  imprimirMedicao("linha inteira, do fim da linha ate a funcao", linhaInteira);
+}
+
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+// Checksum da linha, calculado como em gerenciadorComandos.cpp (XOR ou CRC-8 com polinômio 0x07).
+static uint8_t calcularChecksum(const char* texto) {
+  uint8_t checksum = 0;
+  for (const char* c = texto; *c != '\0'; c++) {
+    checksum ^= (uint8_t)*c;
+#if GC_CHECKSUM == GC_CHECKSUM_CRC8
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      checksum = (checksum & 0x80) ? (uint8_t)((checksum << 1) ^ 0x07) : (uint8_t)(checksum << 1);
+    }
+#endif
+  }
+  return checksum;
+}
+#endif
+
+static void medirChecksum() {
+#if GC_CHECKSUM != GC_CHECKSUM_NENHUM
+  char texto[sizeof(LINHA_TESTE) + 3]; // Linha + "*XX".
+  snprintf(texto, sizeof(texto), "%s*%02X", LINHA_TESTE, calcularChecksum(LINHA_TESTE));
+  Medicao porByte, ateFuncao;
+  porByte.limpar();
+  ateFuncao.limpar();
+  for (int i = 0; i < REPETICOES; i++) {
+    medirLinhaPorByte(texto, porByte, ateFuncao);
+  }
+  imprimirLinha(texto);
+  imprimirMedicao("com checksum, cada byte antes do fim da linha", porByte);
+  imprimirMedicao("com checksum, do fim da linha ate a funcao", ateFuncao);
+#else
+  Serial.println("Checksum desativado (GC_CHECKSUM=0).");
+#endif
+}
+
+// Entrega a linha ao gerenciador e mede do '\n' até o fim da função de tratamento.
+static void medirLinhaCompleta(const char* texto, Medicao& ateRetorno) {
+  for (const char* c = texto; *c != '\0'; c++) gerenciador.receberByte(*c);
+  Tiques inicio = tiques();
+  gerenciador.receberByte('\n');
+  ateRetorno.registrar(inicio, tiques());
+}
+
+static void medirDespacho() {
+  static const char* const linhas[] = {"desligarLed", "medir"};
+  for (uint8_t i = 0; i < sizeof(linhas) / sizeof(linhas[0]); i++) {
+    Medicao ateRetorno;
+    ateRetorno.limpar();
+    for (int j = 0; j < REPETICOES; j++) {
+      medirLinhaCompleta(linhas[i], ateRetorno);
+    }
+    char nome[64]; // Nome único por linha (medir.py).
+    snprintf(nome, sizeof(nome), "%s, do fim da linha ao retorno da funcao", linhas[i]);
+    imprimirMedicao(nome, ateRetorno);
+  }
+}
+
+// Opções de compilação em uso (as mesmas para a biblioteca e para este sketch).
+#define GC_TEXTO(...) GC_TEXTO_(__VA_ARGS__) // Variádicas: a lista de etapas pode conter vírgulas.
+#define GC_TEXTO_(...) #__VA_ARGS__
+static void imprimirConfiguracao() {
+  Serial.print("Configuracao: GC_BUSCA=");
+  Serial.print(GC_BUSCA);
+  Serial.print(" GC_CHECKSUM=");
+  Serial.print(GC_CHECKSUM);
+  Serial.print(" GC_DESPACHO_ESTATICO=");
+  Serial.print(GC_DESPACHO_ESTATICO);
+  Serial.print(" GC_ETAPAS_DESPACHO=");
+  Serial.println(GC_TEXTO(GC_ETAPAS_DESPACHO));
+}
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(ledPin, OUTPUT);
+  iniciarCronometro();
+  imprimirConfiguracao();
+  medirReconhecimento();
+  medirChecksum();
+  medirDespacho();
+  Serial.println("Fim das medicoes.");
+}
+
+void loop() {
+}